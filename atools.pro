@@ -166,11 +166,13 @@ HEADERS += \
   src/fs/weather/weathertypes.h \
   src/fs/weather/xpweatherreader.h \
   src/geo/calculations.h \
+  src/geo/greatcircledensifier.h \
   src/geo/line.h \
   src/geo/linestring.h \
   src/geo/point3d.h \
   src/geo/pos.h \
   src/geo/rect.h \
+  src/geo/segmentspatialindex.h \
   src/geo/simplespatialindex.h \
   src/geo/nanoflann.h \
   src/geo/spatialindex.h \
@@ -197,6 +199,7 @@ HEADERS += \
   src/httpserver/httpconnectionhandler.h \
   src/httpserver/httpconnectionhandlerpool.h \
   src/httpserver/httpcookie.h \
+  src/httpserver/httpeventstream.h \
   src/httpserver/httpglobal.h \
   src/httpserver/httplistener.h \
   src/httpserver/httprequest.h \
@@ -218,6 +221,7 @@ HEADERS += \
   src/routing/routenetwork.h \
   src/routing/routenetworktypes.h \
   src/settings/settings.h \
+  src/sql/sqlcompressedfile.h \
   src/sql/sqldatabase.h \
   src/sql/sqlexception.h \
   src/sql/sqlexport.h \
@@ -276,11 +280,13 @@ SOURCES += \
   src/fs/weather/weathertypes.cpp \
   src/fs/weather/xpweatherreader.cpp \
   src/geo/calculations.cpp \
+  src/geo/greatcircledensifier.cpp \
   src/geo/line.cpp \
   src/geo/linestring.cpp \
   src/geo/point3d.cpp \
   src/geo/pos.cpp \
   src/geo/rect.cpp \
+  src/geo/segmentspatialindex.cpp \
   src/geo/simplespatialindex.cpp \
   src/geo/spatialindex.cpp \
   src/grib/windquery.cpp \
@@ -306,6 +312,7 @@ SOURCES += \
   src/httpserver/httpconnectionhandler.cpp \
   src/httpserver/httpconnectionhandlerpool.cpp \
   src/httpserver/httpcookie.cpp \
+  src/httpserver/httpeventstream.cpp \
   src/httpserver/httpglobal.cpp \
   src/httpserver/httplistener.cpp \
   src/httpserver/httprequest.cpp \
@@ -326,6 +333,7 @@ SOURCES += \
   src/routing/routenetwork.cpp \
   src/routing/routenetworktypes.cpp \
   src/settings/settings.cpp \
+  src/sql/sqlcompressedfile.cpp \
   src/sql/sqldatabase.cpp \
   src/sql/sqlexception.cpp \
   src/sql/sqlexport.cpp \
@@ -412,11 +420,14 @@ HEADERS += \
   src/fs/bgl/subsection.h \
   src/fs/bgl/util.h \
   src/fs/common/airportindex.h \
+  src/fs/common/airspacecrossingindex.h \
   src/fs/common/binarygeometry.h \
   src/fs/common/globereader.h \
+  src/fs/common/indexhash.h \
   src/fs/common/magdecreader.h \
   src/fs/common/metadatawriter.h \
   src/fs/common/morareader.h \
+  src/fs/common/navsnapshot.h \
   src/fs/common/procedurewriter.h \
   src/fs/common/xpgeometry.h \
   src/fs/db/airwayresolver.h \
@@ -442,6 +453,8 @@ HEADERS += \
   src/fs/db/databasemeta.h \
   src/fs/db/datawriter.h \
   src/fs/db/dbairportindex.h \
+  src/fs/db/duplicateremover.h \
+  src/fs/db/mapoverviewwriter.h \
   src/fs/db/meta/bglfilewriter.h \
   src/fs/db/meta/sceneryareawriter.h \
   src/fs/db/nav/airwaysegmentwriter.h \
@@ -452,8 +465,10 @@ HEADERS += \
   src/fs/db/nav/tacanwriter.h \
   src/fs/db/nav/vorwriter.h \
   src/fs/db/nav/waypointwriter.h \
+  src/fs/db/navreferenceupdater.h \
   src/fs/db/routeedgewriter.h \
   src/fs/db/runwayindex.h \
+  src/fs/db/spatialclusterer.h \
   src/fs/db/writerbase.h \
   src/fs/db/writerbasebasic.h \
   src/fs/dfd/dfdcompiler.h \
@@ -472,11 +487,13 @@ HEADERS += \
   src/fs/perf/aircraftperf.h \
   src/fs/perf/aircraftperfconstants.h \
   src/fs/perf/aircraftperfhandler.h \
+  src/fs/perf/aircraftperfprofile.h \
   src/fs/pln/flightplan.h \
   src/fs/pln/flightplanconstants.h \
   src/fs/pln/flightplanentry.h \
   src/fs/pln/flightplanio.h \
   src/fs/progresshandler.h \
+  src/routing/routealternatives.h \
   src/routing/routefinder.h \
   src/fs/scenery/addoncfg.h \
   src/fs/scenery/addoncomponent.h \
@@ -488,6 +505,7 @@ HEADERS += \
   src/fs/util/coordinates.h \
   src/fs/util/fsutil.h \
   src/fs/util/morsecode.h \
+  src/fs/util/namematcher.h \
   src/fs/util/tacanfrequencies.h \
   src/fs/xp/airwaypostprocess.h \
   src/fs/xp/scenerypacks.h \
@@ -555,11 +573,13 @@ SOURCES += \
   src/fs/bgl/subsection.cpp \
   src/fs/bgl/util.cpp \
   src/fs/common/airportindex.cpp \
+  src/fs/common/airspacecrossingindex.cpp \
   src/fs/common/binarygeometry.cpp \
   src/fs/common/globereader.cpp \
   src/fs/common/magdecreader.cpp \
   src/fs/common/metadatawriter.cpp \
   src/fs/common/morareader.cpp \
+  src/fs/common/navsnapshot.cpp \
   src/fs/common/procedurewriter.cpp \
   src/fs/common/xpgeometry.cpp \
   src/fs/db/airwayresolver.cpp \
@@ -585,6 +605,8 @@ SOURCES += \
   src/fs/db/databasemeta.cpp \
   src/fs/db/datawriter.cpp \
   src/fs/db/dbairportindex.cpp \
+  src/fs/db/duplicateremover.cpp \
+  src/fs/db/mapoverviewwriter.cpp \
   src/fs/db/meta/bglfilewriter.cpp \
   src/fs/db/meta/sceneryareawriter.cpp \
   src/fs/db/nav/airwaysegmentwriter.cpp \
@@ -595,8 +617,10 @@ SOURCES += \
   src/fs/db/nav/tacanwriter.cpp \
   src/fs/db/nav/vorwriter.cpp \
   src/fs/db/nav/waypointwriter.cpp \
+  src/fs/db/navreferenceupdater.cpp \
   src/fs/db/routeedgewriter.cpp \
   src/fs/db/runwayindex.cpp \
+  src/fs/db/spatialclusterer.cpp \
   src/fs/db/writerbasebasic.cpp \
   src/fs/dfd/dfdcompiler.cpp \
   src/fs/fspaths.cpp \
@@ -614,11 +638,13 @@ SOURCES += \
   src/fs/perf/aircraftperf.cpp \
   src/fs/perf/aircraftperfconstants.cpp \
   src/fs/perf/aircraftperfhandler.cpp \
+  src/fs/perf/aircraftperfprofile.cpp \
   src/fs/pln/flightplan.cpp \
   src/fs/pln/flightplanconstants.cpp \
   src/fs/pln/flightplanentry.cpp \
   src/fs/pln/flightplanio.cpp \
   src/fs/progresshandler.cpp \
+  src/routing/routealternatives.cpp \
   src/routing/routefinder.cpp \
   src/fs/scenery/addoncfg.cpp \
   src/fs/scenery/addoncomponent.cpp \
@@ -630,6 +656,7 @@ SOURCES += \
   src/fs/util/coordinates.cpp \
   src/fs/util/fsutil.cpp \
   src/fs/util/morsecode.cpp \
+  src/fs/util/namematcher.cpp \
   src/fs/util/tacanfrequencies.cpp \
   src/fs/xp/airwaypostprocess.cpp \
   src/fs/xp/scenerypacks.cpp \
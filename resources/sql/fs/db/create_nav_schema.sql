@@ -365,3 +365,27 @@ create table mora_grid
   laty_rows integer not null,
   geometry blob not null
 );
+
+-- **************************************************
+
+drop table if exists map_overview;
+
+-- Precomputed selection of the most important airports and navaids for each zoom level and tile.
+-- Zoom level z divides the world into 2^z by 2^z tiles. Each tile contains at most a fixed number of objects.
+-- An object selected on one zoom level is also selected on all higher levels.
+-- Filled by atools::fs::db::MapOverviewWriter.
+create table map_overview
+(
+  map_overview_id integer primary key,
+  type varchar(1) not null,      -- A = airport, V = VOR, N = NDB, W = waypoint
+  nav_id integer not null,       -- airport.airport_id, vor.vor_id, ndb.ndb_id or waypoint.waypoint_id
+  zoom integer not null,         -- Zoom level starting with 0 for the whole world
+  tile_x integer not null,       -- Tile column from west at -180
+  tile_y integer not null,       -- Tile row from north at 90
+  tile_rank integer not null,    -- Rank in tile. 0 is the most important object.
+  importance integer not null,   -- Type dependent importance used for ranking
+  lonx double not null,
+  laty double not null
+);
+
+create index if not exists idx_map_overview_tile on map_overview(type, zoom, tile_x, tile_y);
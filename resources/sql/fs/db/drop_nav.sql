@@ -32,4 +32,5 @@ drop table if exists vor;
 drop table if exists waypoint;
 drop table if exists boundary;
 drop table if exists mora_grid;
+drop table if exists map_overview;
 
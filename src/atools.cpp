@@ -26,6 +26,8 @@
 #include <QTextCodec>
 #include <QCoreApplication>
 #include <QDateTime>
+#include <QMutex>
+#include <QHash>
 
 namespace atools {
 
@@ -195,6 +197,130 @@ bool contains(const QString& name, const std::initializer_list<const char *>& li
   return false;
 }
 
+#if !defined(Q_OS_WIN32)
+
+/* Cached directory listing for buildPathNoCase() */
+struct DirListing
+{
+  QDateTime lastModified;
+
+  /* Real name to directory flag for exact matches */
+  QHash<QString, bool> names;
+
+  /* Case folded name to real name and directory flag. First entry in sort order wins for duplicates. */
+  QHash<QString, QPair<QString, bool> > entries;
+};
+
+static QHash<QString, DirListing> dirListingCache;
+static QMutex dirListingCacheMutex;
+
+/* Number of active PathNoCaseCacheScope objects. Cache is used only if not zero. */
+static int dirListingCacheScopes = 0;
+
+/* Find entry in directory ignoring case. Uses the expensive uncached directory listing. */
+static bool findEntryNoCaseUncached(const QDir& dir, const QString& path, QString& entry, bool& isDir)
+{
+  // Get entries that match exacly the next path element
+  QStringList entries = dir.entryList({path});
+
+  if(entries.isEmpty())
+  {
+    // Nothing found - do an expensive manual compare
+    for(const QString& str: dir.entryList())
+    {
+      if(str.compare(path, Qt::CaseInsensitive) == 0)
+      {
+        // Found something - use it as the single entry
+        entries.append(str);
+        break;
+      }
+    }
+  }
+
+  if(!entries.isEmpty())
+  {
+    entry = entries.first();
+    isDir = QFileInfo(dir.path() + QDir::separator() + entry).isDir();
+    return true;
+  }
+  return false;
+}
+
+/* Find entry in directory ignoring case using a cached listing which is reloaded if the directory
+ * modification time changes */
+static bool findEntryNoCase(const QDir& dir, const QString& path, QString& entry, bool& isDir)
+{
+  if(path.contains('*') || path.contains('?') || path.contains('['))
+    // Name is used as a wildcard filter - cannot look up in cache
+    return findEntryNoCaseUncached(dir, path, entry, isDir);
+
+  QMutexLocker locker(&dirListingCacheMutex);
+  if(dirListingCacheScopes == 0)
+  {
+    // Not scanning or compiling - do not cache
+    locker.unlock();
+    return findEntryNoCaseUncached(dir, path, entry, isDir);
+  }
+
+  QString dirPath = dir.path();
+  QDateTime lastModified = QFileInfo(dirPath).lastModified();
+  DirListing& listing = dirListingCache[dirPath];
+
+  if(listing.names.isEmpty() || listing.lastModified != lastModified)
+  {
+    // Not cached or directory changed - use the same filter and sort order as the uncached lookup
+    listing.lastModified = lastModified;
+    listing.names.clear();
+    listing.entries.clear();
+    for(const QFileInfo& info : dir.entryInfoList())
+    {
+      listing.names.insert(info.fileName(), info.isDir());
+
+      QString key = info.fileName().toCaseFolded();
+      if(!listing.entries.contains(key))
+        listing.entries.insert(key, qMakePair(info.fileName(), info.isDir()));
+    }
+  }
+
+  // Exact match has priority like in the uncached lookup
+  auto nameIt = listing.names.constFind(path);
+  if(nameIt != listing.names.constEnd())
+  {
+    entry = nameIt.key();
+    isDir = nameIt.value();
+    return true;
+  }
+
+  auto it = listing.entries.constFind(path.toCaseFolded());
+  if(it != listing.entries.constEnd())
+  {
+    entry = it.value().first;
+    isDir = it.value().second;
+    return true;
+  }
+  return false;
+}
+
+#endif
+
+PathNoCaseCacheScope::PathNoCaseCacheScope()
+{
+#if !defined(Q_OS_WIN32)
+  QMutexLocker locker(&dirListingCacheMutex);
+  dirListingCacheScopes++;
+#endif
+}
+
+PathNoCaseCacheScope::~PathNoCaseCacheScope()
+{
+#if !defined(Q_OS_WIN32)
+  QMutexLocker locker(&dirListingCacheMutex);
+  if(--dirListingCacheScopes == 0)
+    // Free memory used by the directory listings
+    dirListingCache.clear();
+#endif
+}
+
 QString buildPathNoCase(const QStringList& paths)
 {
 
@@ -214,44 +340,20 @@ QString buildPathNoCase(const QStringList& paths)
       dir = path;
     else
     {
-      // Get entries that match exacly the next path element
-      QStringList entries = dir.entryList({path});
-
-      if(entries.isEmpty())
-      {
-        // Nothing found - do an expensive manual compare
-        bool found = false;
-        entries = dir.entryList();
-
-        for(const QString& str: entries)
-        {
-          if(str.compare(path, Qt::CaseInsensitive) == 0)
-          {
-            // Found something - use it as the single entry
-            entries.clear();
-            entries.append(str);
-            found = true;
-            break;
-          }
-        }
-
-        if(!found)
-          // Nothing found when searching case insensitive
-          entries.clear();
-      }
-
-      if(!entries.isEmpty())
+      QString entry;
+      bool isDir = false;
+      if(findEntryNoCase(dir, path, entry, isDir))
       {
-        if(QFileInfo(dir.path() + QDir::separator() + entries.first()).isDir())
+        if(isDir)
         {
           // Directory exists - change into it
-          if(!dir.cd(entries.first()))
+          if(!dir.cd(entry))
             break;
         }
         else
         {
           // Is a file - add by name simply
-          file = entries.first();
+          file = entry;
           break;
         }
       }
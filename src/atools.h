@@ -91,9 +91,24 @@ QString blockText(const QStringList& texts, int maxItemsPerLine, const QString&
 /* Cut linefeed separated text. Return maxLength lines where \n... is included  */
 QString elideTextLinesShort(QString str, int maxLines, int maxLength = 0);
 
-/* Concatenates all paths parts with the QDir::separator() and fetches names correcting the case */
+/* Concatenates all paths parts with the QDir::separator() and fetches names correcting the case.
+ * Directory listings are cached while a PathNoCaseCacheScope exists and reloaded when the directory
+ * modification time changes. Thread safe. */
 QString buildPathNoCase(const QStringList& paths);
 
+/* Enables the directory listing cache of buildPathNoCase() for the lifetime of this object.
+ * Use around scanning or compiling. Scopes can be nested and the cache is cleared when the last one ends.
+ * buildPathNoCase() does not cache without a scope. */
+class PathNoCaseCacheScope
+{
+public:
+  PathNoCaseCacheScope();
+  ~PathNoCaseCacheScope();
+
+  PathNoCaseCacheScope(const PathNoCaseCacheScope& other) = delete;
+  PathNoCaseCacheScope& operator=(const PathNoCaseCacheScope& other) = delete;
+};
+
 /* Simply concatenates all paths parts with the QDir::separator() */
 QString buildPath(const QStringList& paths);
 
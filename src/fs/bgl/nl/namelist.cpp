@@ -20,11 +20,134 @@
 #include "io/binarystream.h"
 #include "fs/bgl/converter.h"
 
+#include <QVector>
+
+#include <algorithm>
+
 namespace atools {
 namespace fs {
 namespace bgl {
 using atools::io::BinaryStream;
 
+namespace {
+
+/* Little endian reader for a record held in memory. Reads beyond the end return 0. */
+class RecordBuffer
+{
+public:
+  RecordBuffer(const QByteArray& recordBytes)
+    : bytes(recordBytes), data(reinterpret_cast<const uchar *>(recordBytes.constData())), size(recordBytes.size())
+  {
+  }
+
+  void seek(int offset)
+  {
+    pos = offset;
+  }
+
+  quint8 readUByte()
+  {
+    quint8 retval = pos >= 0 && pos < size ? data[pos] : 0;
+    pos++;
+    return retval;
+  }
+
+  qint16 readShort()
+  {
+    return static_cast<qint16>(readUShort());
+  }
+
+  quint16 readUShort()
+  {
+    quint16 retval = static_cast<quint16>(readUByte());
+    return static_cast<quint16>(retval | (readUByte() << 8));
+  }
+
+  qint32 readInt()
+  {
+    return static_cast<qint32>(readUInt());
+  }
+
+  quint32 readUInt()
+  {
+    quint32 retval = readUShort();
+    return retval | (static_cast<quint32>(readUShort()) << 16);
+  }
+
+  void skip(int num)
+  {
+    pos += num;
+  }
+
+  int tell() const
+  {
+    return pos;
+  }
+
+  /* Same as BinaryStream::readString() but without advancing the position */
+  QString stringAt(int offset) const
+  {
+    if(offset < 0 || offset >= size)
+      return QString();
+
+    const char *str = bytes.constData() + offset;
+    int len = 0;
+    while(offset + len < size && str[len] != 0 && !iscntrl(str[len]))
+      len++;
+    return QString::fromLatin1(str, len);
+  }
+
+private:
+  const QByteArray& bytes;
+  const uchar *data;
+  int size, pos = 0;
+};
+
+/* Name list which decodes each name only once. All entries referencing a name share the decoded string. */
+class SharedNameList
+{
+public:
+  SharedNameList(RecordBuffer& buffer, int numNames, int listOffset)
+    : record(buffer)
+  {
+    if(numNames < 0)
+      numNames = 0;
+
+    record.seek(listOffset);
+    offsets.resize(numNames);
+    for(int i = 0; i < numNames; i++)
+      offsets[i] = record.readInt();
+
+    // String offsets are relative to the end of the index list
+    base = record.tell();
+    names.resize(numNames);
+    decoded.fill(false, numNames);
+  }
+
+  /* Get decoded name or empty string if index is out of range. Decodes the name on first access. */
+  QString value(int index)
+  {
+    if(index < 0 || index >= offsets.size())
+      return QString();
+
+    if(!decoded.at(index))
+    {
+      names[index] = record.stringAt(base + offsets.at(index));
+      decoded[index] = true;
+    }
+    return names.at(index);
+  }
+
+private:
+  RecordBuffer& record;
+  QVector<int> offsets;
+  QVector<QString> names;
+  QVector<bool> decoded;
+  int base = 0;
+};
+
+} // namespace
+
 Namelist::Namelist(const NavDatabaseOptions *options, BinaryStream *bs)
   : Record(options, bs)
 {
@@ -42,38 +165,37 @@ Namelist::Namelist(const NavDatabaseOptions *options, BinaryStream *bs)
   int airportListOffset = bs->readInt();
   int icaoListOffset = bs->readInt();
 
-  // Read all names from the different offsets
-  QStringList regions;
-  readList(regions, bs, numRegionNames, regionListOffset);
-
-  QStringList countries;
-  readList(countries, bs, numCountryNames, countryListOffset);
+  // Read the whole record at once and decode from memory instead of seeking for each name
+  qint64 recordSize = std::min(static_cast<qint64>(getSize()), bs->getFileSize() - startOffset);
+  QByteArray bytes(static_cast<int>(std::max(recordSize, static_cast<qint64>(0))), '\0');
+  bs->seekg(startOffset);
+  bs->readBytes(bytes.data(), bytes.size());
+  RecordBuffer record(bytes);
 
-  QStringList states;
-  readList(states, bs, numStateNames, stateListOffset);
-
-  QStringList cities;
-  readList(cities, bs, numCityNames, cityListOffset);
-
-  QStringList airports;
-  readList(airports, bs, numAirportNames, airportListOffset);
+  // Index the names from the different offsets - names are decoded once and shared between entries
+  SharedNameList regions(record, numRegionNames, regionListOffset);
+  SharedNameList countries(record, numCountryNames, countryListOffset);
+  SharedNameList states(record, numStateNames, stateListOffset);
+  SharedNameList cities(record, numCityNames, cityListOffset);
+  SharedNameList airports(record, numAirportNames, airportListOffset);
 
   // Goto to the offset that contains the name indexes
-  bs->seekg(startOffset + icaoListOffset);
+  record.seek(icaoListOffset);
 
   // Now put the names into NamelistEntrys
+  entries.reserve(std::max(numICAO, 0));
   for(int i = 0; i < numICAO; i++)
   {
     NamelistEntry icaoRec;
-    icaoRec.regionName = regions.value(bs->readUByte());
-    icaoRec.countryName = countries.value(bs->readUByte());
-    icaoRec.stateName = states.value(bs->readShort() >> 4);
-    icaoRec.cityName = cities.value(bs->readShort());
-    icaoRec.airportName = airports.value(bs->readShort());
-    icaoRec.airportIdent = converter::intToIcao(bs->readUInt());
-    icaoRec.regionIdent = converter::intToIcao(bs->readUInt());
+    icaoRec.regionName = regions.value(record.readUByte());
+    icaoRec.countryName = countries.value(record.readUByte());
+    icaoRec.stateName = states.value(record.readShort() >> 4);
+    icaoRec.cityName = cities.value(record.readShort());
+    icaoRec.airportName = airports.value(record.readShort());
+    icaoRec.airportIdent = converter::intToIcao(record.readUInt());
+    icaoRec.regionIdent = converter::intToIcao(record.readUInt());
 
-    bs->skip(4); // QMID Level 9 Square.
+    record.skip(4); // QMID Level 9 Square.
 
     entries.append(icaoRec);
   }
@@ -83,23 +205,6 @@ Namelist::~Namelist()
 {
 }
 
-void Namelist::readList(QStringList& names, BinaryStream *bs, int numNames, int listOffset)
-{
-  bs->seekg(startOffset + listOffset);
-
-  int *indexes = new int[numNames];
-  for(int i = 0; i < numNames; i++)
-    indexes[i] = bs->readInt();
-
-  qint64 offs = bs->tellg();
-  for(int i = 0; i < numNames; i++)
-  {
-    bs->seekg(offs + indexes[i]);
-    names.append(bs->readString());
-  }
-  delete[] indexes;
-}
-
 QDebug operator<<(QDebug out, const Namelist& record)
 {
   QDebugStateSaver saver(out);
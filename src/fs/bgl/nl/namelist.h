@@ -56,8 +56,6 @@ private:
 
   QList<atools::fs::bgl::NamelistEntry> entries;
 
-  void readList(QStringList& names, atools::io::BinaryStream *bs, int numRegionNames, int regionListOffset);
-
 };
 
 } // namespace bgl
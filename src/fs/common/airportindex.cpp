@@ -17,21 +17,56 @@
 
 #include "fs/common/airportindex.h"
 
+#include <QDebug>
+#include <QStringBuilder>
+
+#include <algorithm>
+
 namespace atools {
 namespace fs {
 namespace common {
 
 static QLatin1String EN_ROUTE("ENRT");
 
-IndexName::IndexName(const QString& str)
+/* Copy Latin-1 characters into fixed size buffer and fill remaining space with blanks */
+static void fillName(char *name, int size, const QString& str)
+{
+  const QChar *data = str.constData();
+  int len = std::min(size, str.size());
+  for(int i = 0; i < len; i++)
+    name[i] = data[i].toLatin1();
+  memset(name + len, ' ', static_cast<size_t>(size - len));
+}
+
+/* true if string is not longer than size, has only Latin-1 characters and no trailing blank which would
+ * alias with the padding */
+static bool fitsName(int size, const QString& str)
 {
-  for(int i = 0; i < SIZE; i++)
+  if(str.size() > size || (!str.isEmpty() && str.at(str.size() - 1) == QLatin1Char(' ')))
+    return false;
+
+  for(const QChar& c : str)
   {
-    if(i < str.size())
-      name[i] = str.at(i).toLatin1();
-    else
-      name[i] = ' ';
+    if(c.unicode() > 0xff)
+      return false;
   }
+  return true;
+}
+
+/* Key for fallback maps. Tab is not used in idents. */
+inline static QString fallbackKey(const QString& str1, const QString& str2)
+{
+  return str1 % QLatin1Char('\t') % str2;
+}
+
+inline static QString fallbackKey(const QString& str1, const QString& str2, const QString& str3)
+{
+  return str1 % QLatin1Char('\t') % str2 % QLatin1Char('\t') % str3;
+}
+
+IndexName::IndexName(const QString& str)
+{
+  fillName(name, SIZE, str);
 }
 
 IndexName::IndexName()
@@ -39,31 +74,21 @@ IndexName::IndexName()
   memset(name, ' ', SIZE);
 }
 
-uint qHash(const IndexName& name)
+bool IndexName::fits(const QString& str)
 {
-  int retval = 0;
-  for(int i = 0; i < IndexName::SIZE; i++)
-    retval ^= name.name[i] << ((i % 4) * 8);
+  return fitsName(SIZE, str);
+}
 
-  return static_cast<uint>(retval);
+uint qHash(const IndexName& name)
+{
+  // Keys are used in open addressing tables which need all bits well distributed
+  return qHashBits(name.name, IndexName::SIZE);
 }
 
 IndexName2::IndexName2(const QString& str1, const QString& str2)
 {
-  for(int i = 0; i < SIZE / 2; i++)
-  {
-    if(i < str1.size())
-      name[i] = str1.at(i).toLatin1();
-    else
-      name[i] = ' ';
-  }
-  for(int i = 0; i < SIZE / 2; i++)
-  {
-    if(i < str2.size())
-      name[i + SIZE / 2] = str2.at(i).toLatin1();
-    else
-      name[i + SIZE / 2] = ' ';
-  }
+  fillName(name, SIZE / 2, str1);
+  fillName(name + SIZE / 2, SIZE / 2, str2);
 }
 
 IndexName2::IndexName2()
@@ -71,13 +96,36 @@ IndexName2::IndexName2()
   memset(name, ' ', SIZE);
 }
 
+bool IndexName2::fits(const QString& str1, const QString& str2)
+{
+  return fitsName(SIZE / 2, str1) && fitsName(SIZE / 2, str2);
+}
+
 uint qHash(const IndexName2& name)
 {
-  int retval = 0;
-  for(int i = 0; i < IndexName2::SIZE; i++)
-    retval ^= name.name[i] << ((i % 4) * 8);
+  return qHashBits(name.name, IndexName2::SIZE);
+}
+
+IndexName3::IndexName3(const QString& str1, const QString& str2, const QString& str3)
+{
+  fillName(name, SIZE1, str1);
+  fillName(name + SIZE1, SIZE2, str2);
+  fillName(name + SIZE1 + SIZE2, SIZE3, str3);
+}
 
-  return static_cast<uint>(retval);
+IndexName3::IndexName3()
+{
+  memset(name, ' ', SIZE);
+}
+
+bool IndexName3::fits(const QString& str1, const QString& str2, const QString& str3)
+{
+  return fitsName(SIZE1, str1) && fitsName(SIZE2, str2) && fitsName(SIZE3, str3);
+}
+
+uint qHash(const IndexName3& name)
+{
+  return qHashBits(name.name, IndexName3::SIZE);
 }
 
 // ==========================================================================
@@ -90,7 +138,8 @@ QVariant AirportIndex::getAirportId(const QString& airportIcao)
 {
   if(airportIcao != EN_ROUTE)
   {
-    int id = icaoToIdMap.value(IndexName(airportIcao), -1);
+    int id = IndexName::fits(airportIcao) ?
+             icaoToIdMap.value(IndexName(airportIcao), -1) : icaoToIdFallback.value(airportIcao, -1);
     if(id != -1)
       return id;
   }
@@ -101,7 +150,9 @@ QVariant AirportIndex::getRunwayEndId(const QString& airportIcao, const QString&
 {
   if(airportIcao != EN_ROUTE) // en route
   {
-    int id = icaoRunwayNameToEndId.value(IndexName2(airportIcao, runwayName), -1);
+    int id = IndexName2::fits(airportIcao, runwayName) ?
+             icaoRunwayNameToEndId.value(IndexName2(airportIcao, runwayName), -1) :
+             icaoRunwayNameToEndIdFallback.value(fallbackKey(airportIcao, runwayName), -1);
     if(id != -1)
       return id;
   }
@@ -110,41 +161,71 @@ QVariant AirportIndex::getRunwayEndId(const QString& airportIcao, const QString&
 
 bool AirportIndex::addAirport(const QString& airportIcao, int airportId)
 {
-  if(icaoToIdMap.contains(IndexName(airportIcao)))
+  if(IndexName::fits(airportIcao))
+    return icaoToIdMap.insertNew(IndexName(airportIcao), airportId);
+
+  qWarning() << Q_FUNC_INFO << "Airport ident does not fit into index" << airportIcao;
+  if(icaoToIdFallback.contains(airportIcao))
     return false;
-  else
-  {
-    icaoToIdMap.insert(IndexName(airportIcao), airportId);
-    return true;
-  }
+
+  icaoToIdFallback.insert(airportIcao, airportId);
+  return true;
 }
 
 void AirportIndex::addRunwayEnd(const QString& airportIcao, const QString& runwayName, int runwayEndId)
 {
-  icaoRunwayNameToEndId.insert(IndexName2(airportIcao, runwayName), runwayEndId);
+  if(IndexName2::fits(airportIcao, runwayName))
+    icaoRunwayNameToEndId.insert(IndexName2(airportIcao, runwayName), runwayEndId);
+  else
+  {
+    qWarning() << Q_FUNC_INFO << "Runway name does not fit into index" << airportIcao << runwayName;
+    icaoRunwayNameToEndIdFallback.insert(fallbackKey(airportIcao, runwayName), runwayEndId);
+  }
 }
 
 void AirportIndex::addAirportIls(const QString& airportIcao, const QString& airportRegion, const QString& ilsIdent,
                                  int ilsId)
 {
-  airportIlsIdMap.insert(QString("%1|%2|%3").arg(airportIcao).arg(airportRegion).arg(ilsIdent), ilsId);
+  if(IndexName3::fits(airportIcao, airportRegion, ilsIdent))
+    airportIlsIdMap.insert(IndexName3(airportIcao, airportRegion, ilsIdent), ilsId);
+  else
+  {
+    qWarning() << Q_FUNC_INFO << "ILS ident does not fit into index" << airportIcao << airportRegion << ilsIdent;
+    airportIlsIdFallback.insert(fallbackKey(airportIcao, airportRegion, ilsIdent), ilsId);
+  }
 }
 
 int AirportIndex::getAirportIlsId(const QString& airportIcao, const QString& airportRegion, const QString& ilsIdent)
 {
-  return airportIlsIdMap.value(QString("%1|%2|%3").arg(airportIcao).arg(airportRegion).arg(ilsIdent), -1);
+  if(IndexName3::fits(airportIcao, airportRegion, ilsIdent))
+    return airportIlsIdMap.value(IndexName3(airportIcao, airportRegion, ilsIdent), -1);
+  else
+    return airportIlsIdFallback.value(fallbackKey(airportIcao, airportRegion, ilsIdent), -1);
 }
 
 void AirportIndex::addSkippedAirportIls(const QString& airportIcao, const QString& airportRegion,
                                         const QString& ilsIdent)
 {
-  skippedIlsSet.insert(QString("%1|%2|%3").arg(airportIcao).arg(airportRegion).arg(ilsIdent));
+  if(IndexName3::fits(airportIcao, airportRegion, ilsIdent))
+    skippedIlsSet.insert(IndexName3(airportIcao, airportRegion, ilsIdent), 0);
+  else
+    skippedIlsFallback.insert(fallbackKey(airportIcao, airportRegion, ilsIdent), 0);
 }
 
 bool AirportIndex::hasSkippedAirportIls(const QString& airportIcao, const QString& airportRegion,
                                         const QString& ilsIdent)
 {
-  return skippedIlsSet.contains(QString("%1|%2|%3").arg(airportIcao).arg(airportRegion).arg(ilsIdent));
+  if(IndexName3::fits(airportIcao, airportRegion, ilsIdent))
+    return skippedIlsSet.contains(IndexName3(airportIcao, airportRegion, ilsIdent));
+  else
+    return skippedIlsFallback.contains(fallbackKey(airportIcao, airportRegion, ilsIdent));
+}
+
+qint64 AirportIndex::memorySize() const
+{
+  // Fallback maps are usually empty and not counted
+  return icaoToIdMap.memorySize() + airportIlsIdMap.memorySize() + skippedIlsSet.memorySize() +
+         icaoRunwayNameToEndId.memorySize();
 }
 
 } // namespace common
@@ -18,21 +18,26 @@
 #ifndef ATOOLS_XPAIRPORTINDEX_H
 #define ATOOLS_XPAIRPORTINDEX_H
 
+#include "fs/common/indexhash.h"
+
 #include <QHash>
-#include <QSet>
 #include <QVariant>
 
 namespace atools {
 namespace fs {
 namespace common {
 
-// Helper classes to avoid QString and speed up the hash maps
+// Helper classes to avoid QString and speed up the hash maps.
+// Names are truncated and non Latin-1 characters are replaced. Use fits() to check before creating a key.
 class IndexName
 {
 public:
   explicit IndexName(const QString& str);
   IndexName();
 
+  /* true if the name can be stored without loss and does not alias with other names */
+  static bool fits(const QString& str);
+
 private:
   friend bool operator==(const IndexName& name1, const IndexName& name2);
 
@@ -58,6 +63,8 @@ public:
   explicit IndexName2(const QString& str1, const QString& str2);
   IndexName2();
 
+  static bool fits(const QString& str1, const QString& str2);
+
 private:
   friend bool operator==(const IndexName2& name1, const IndexName2& name2);
 
@@ -77,6 +84,34 @@ inline bool operator!=(const IndexName2& name1, const IndexName2& name2)
   return !operator==(name1, name2);
 }
 
+/* Key for airport ICAO, region and ILS ident */
+class IndexName3
+{
+public:
+  explicit IndexName3(const QString& str1, const QString& str2, const QString& str3);
+  IndexName3();
+
+  static bool fits(const QString& str1, const QString& str2, const QString& str3);
+
+private:
+  friend bool operator==(const IndexName3& name1, const IndexName3& name2);
+
+  friend uint qHash(const IndexName3& name);
+
+  static constexpr int SIZE1 = 10, SIZE2 = 4, SIZE3 = 10, SIZE = SIZE1 + SIZE2 + SIZE3;
+  char name[SIZE];
+};
+
+inline bool operator==(const IndexName3& name1, const IndexName3& name2)
+{
+  return memcmp(name1.name, name2.name, sizeof(name1.name)) == 0;
+}
+
+inline bool operator!=(const IndexName3& name1, const IndexName3& name2)
+{
+  return !operator==(name1, name2);
+}
+
 /*
  * Filled when reading airports in the beginning of the compilation process.
  * Provides an index from airport ICAO to airport_id and runwayname/airport ICAO to runway_end_id.
@@ -104,6 +139,7 @@ public:
   void clearSkippedIls()
   {
     skippedIlsSet.clear();
+    skippedIlsFallback.clear();
   }
 
   void clear()
@@ -111,15 +147,23 @@ public:
     icaoToIdMap.clear();
     icaoRunwayNameToEndId.clear();
     airportIlsIdMap.clear();
+    icaoToIdFallback.clear();
+    icaoRunwayNameToEndIdFallback.clear();
+    airportIlsIdFallback.clear();
   }
 
+  /* Approximate memory used by all indexes in bytes */
+  qint64 memorySize() const;
+
 private:
   // Map ICAO id to database airport_id
-  QHash<IndexName, int> icaoToIdMap;
-  QHash<QString, int> airportIlsIdMap;
-  QSet<QString> skippedIlsSet;
-  QHash<IndexName2, int> icaoRunwayNameToEndId;
+  IndexHash<IndexName> icaoToIdMap;
+  IndexHash<IndexName3> airportIlsIdMap;
+  IndexHash<IndexName3> skippedIlsSet; /* Value is not used */
+  IndexHash<IndexName2> icaoRunwayNameToEndId;
 
+  // Used for names which are too long or contain non Latin-1 characters and would alias in the maps above
+  QHash<QString, int> icaoToIdFallback, airportIlsIdFallback, skippedIlsFallback, icaoRunwayNameToEndIdFallback;
 };
 
 } // namespace common
@@ -127,5 +171,7 @@ private:
 } // namespace atools
 
 Q_DECLARE_TYPEINFO(atools::fs::common::IndexName, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(atools::fs::common::IndexName2, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(atools::fs::common::IndexName3, Q_PRIMITIVE_TYPE);
 
 #endif // ATOOLS_XPAIRPORTINDEX_H
@@ -0,0 +1,487 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/common/airspacecrossingindex.h"
+
+#include "fs/common/binarygeometry.h"
+#include "geo/linestring.h"
+#include "sql/sqlquery.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlutil.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using atools::sql::SqlQuery;
+using atools::sql::SqlUtil;
+using atools::geo::Pos;
+using atools::geo::Line;
+using atools::geo::LineString;
+
+namespace atools {
+namespace fs {
+namespace common {
+
+namespace {
+
+/* Distance tolerance in meter for merging and comparing crossing points */
+const float EPSILON_METER = 1.f;
+
+/* Unit vector in earth centered cartesian coordinates */
+struct Vec
+{
+  double x, y, z;
+
+  static Vec fromPos(const Pos& pos)
+  {
+    Vec v;
+    pos.toCartesian(v.x, v.y, v.z);
+    double len = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+    if(len > 0.)
+    {
+      v.x /= len;
+      v.y /= len;
+      v.z /= len;
+    }
+    return v;
+  }
+
+  Vec operator*(double f) const
+  {
+    return {x * f, y * f, z * f};
+  }
+
+  double dot(const Vec& o) const
+  {
+    return x * o.x + y * o.y + z * o.z;
+  }
+
+  Vec cross(const Vec& o) const
+  {
+    return {y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x};
+  }
+
+  double length() const
+  {
+    return std::sqrt(x * x + y * y + z * z);
+  }
+
+};
+
+/* Intersection of great circle arc a1-a2 including a1 with arc b1-b2 excluding b2. a2 is included if includeA2 is true.
+ * Excluding one end avoids counting crossings at polygon vertices and route points twice.
+ * Returns fraction along first arc or -1 if there is no intersection. Arcs have to be shorter than 180°. */
+double arcIntersection(const Vec& a1, const Vec& a2, const Vec& b1, const Vec& b2, bool includeA2)
+{
+  Vec n1 = a1.cross(a2), n2 = b1.cross(b2);
+  Vec dir = n1.cross(n2);
+  double len = dir.length();
+  if(len < 1.e-12)
+    // Parallel or degenerated arcs
+    return -1.;
+
+  dir = dir * (1. / len);
+
+  // The great circles intersect at dir and -dir
+  for(double sign : {1., -1.})
+  {
+    Vec p = dir * sign;
+    double a2Side = p.cross(a2).dot(n1);
+    if(a1.cross(p).dot(n1) >= 0. && (includeA2 ? a2Side >= 0. : a2Side > 0.) &&
+       b1.cross(p).dot(n2) >= 0. && p.cross(b2).dot(n2) > 0.)
+      return std::atan2(a1.cross(p).length(), a1.dot(p)) / std::atan2(n1.length(), a1.dot(a2));
+  }
+  return -1.;
+}
+
+/* Index of leg containing the distance */
+int legIndexAt(const QVector<float>& legStartDistances, float distanceMeter)
+{
+  int index = static_cast<int>(std::upper_bound(legStartDistances.begin(), legStartDistances.end(), distanceMeter) -
+                               legStartDistances.begin()) - 1;
+  return std::max(0, std::min(index, legStartDistances.size() - 2));
+}
+
+}
+
+AirspaceCrossingIndex::AirspaceCrossingIndex()
+{
+
+}
+
+AirspaceCrossingIndex::~AirspaceCrossingIndex()
+{
+
+}
+
+bool AirspaceCrossingIndex::readFromTable(sql::SqlDatabase *db, const QStringList& types)
+{
+  clear();
+
+  if(!SqlUtil(db).hasTableAndRows("boundary"))
+  {
+    qWarning() << Q_FUNC_INFO << "No airspaces found";
+    return false;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+
+  QString queryStr("select boundary_id, min_altitude, max_altitude, max_altitude_type, geometry from boundary");
+  if(!types.isEmpty())
+  {
+    QStringList placeholders;
+    for(int i = 0; i < types.size(); i++)
+      placeholders.append("?");
+    queryStr += " where type in (" + placeholders.join(",") + ")";
+  }
+
+  SqlQuery query(db);
+  query.prepare(queryStr);
+  for(const QString& type : types)
+    query.addBindValue(type);
+  query.exec();
+  while(query.next())
+  {
+    // Terrain elevation is not known here. AGL values are used as MSL which means that the lower limit is
+    // always correct or too low and the upper limit can be too low above high terrain
+    int minAltitude = query.isNull("min_altitude") ? 0 : query.valueInt("min_altitude");
+
+    int maxAltitude = std::numeric_limits<int>::max();
+    if(!query.isNull("max_altitude") && query.valueStr("max_altitude_type") != "UL")
+      maxAltitude = query.valueInt("max_altitude");
+
+    BinaryGeometry geometry(query.value("geometry").toByteArray());
+    addAirspace(query.valueInt("boundary_id"), geometry.getGeometry(), minAltitude, maxAltitude);
+  }
+
+  build();
+
+  qDebug() << Q_FUNC_INFO << "airspaces" << airspaces.size() << "edges" << edgeIndex.size()
+           << timer.elapsed() << "ms";
+  return !airspaces.isEmpty();
+}
+
+void AirspaceCrossingIndex::addAirspace(int boundaryId, const LineString& polygon, int minAltitudeFt,
+                                        int maxAltitudeFt)
+{
+  if(polygon.size() < 3)
+    return;
+
+  Airspace airspace;
+  airspace.boundaryId = boundaryId;
+  airspace.minAltitudeFt = minAltitudeFt;
+  airspace.maxAltitudeFt = maxAltitudeFt;
+  airspace.bounding = polygon.boundingRect();
+  airspace.firstEdge = edgeIndex.size();
+
+  int airspaceIndex = airspaces.size();
+  for(int i = 0; i < polygon.size(); i++)
+  {
+    // Close polygon if needed
+    const Pos& p1 = polygon.at(i);
+    const Pos& p2 = polygon.at((i + 1) % polygon.size());
+    if(p1.isValid() && p2.isValid() && !p1.almostEqual(p2))
+    {
+      AirspaceEdge edge;
+      edge.line = Line(p1, p2);
+      edge.airspaceIndex = airspaceIndex;
+      edgeIndex.append(edge);
+    }
+  }
+  airspace.numEdges = edgeIndex.size() - airspace.firstEdge;
+
+  if(airspace.numEdges >= 3)
+    airspaces.append(airspace);
+  else
+    // Degenerated polygon
+    edgeIndex.resize(airspace.firstEdge);
+}
+
+void AirspaceCrossingIndex::build()
+{
+  edgeIndex.updateIndex();
+}
+
+void AirspaceCrossingIndex::clear()
+{
+  airspaces.clear();
+  edgeIndex.clear();
+  edgeIndex.updateIndex();
+}
+
+void AirspaceCrossingIndex::findCrossings(QVector<AirspaceCrossing>& crossings, const LineString& route) const
+{
+  crossings.clear();
+  if(route.size() < 2 || airspaces.isEmpty())
+    return;
+
+  // Distance from start for each route point and altitude band of route
+  QVector<float> legStartDistances({0.f});
+  float routeMinAlt = route.first().getAltitude(), routeMaxAlt = routeMinAlt;
+  for(int i = 1; i < route.size(); i++)
+  {
+    legStartDistances.append(legStartDistances.last() + route.at(i - 1).distanceMeterTo(route.at(i)));
+    routeMinAlt = std::min(routeMinAlt, route.at(i).getAltitude());
+    routeMaxAlt = std::max(routeMaxAlt, route.at(i).getAltitude());
+  }
+  float totalDistance = legStartDistances.last();
+
+  auto bandOverlaps = [routeMinAlt, routeMaxAlt](const Airspace& airspace) -> bool {
+                        return routeMinAlt <= airspace.maxAltitudeFt && routeMaxAlt >= airspace.minAltitudeFt;
+                      };
+
+  // Collect lateral boundary crossings for all legs ===========================
+  QVector<Event> events;
+  QVector<int> indexes;
+  for(int i = 0; i < route.size() - 1; i++)
+  {
+    // Legs exclude their end point except the last one - end point is the start of the next leg
+    bool lastLeg = i == route.size() - 2;
+    const Pos& p1 = route.at(i);
+    const Pos& p2 = route.at(i + 1);
+    float legLength = legStartDistances.at(i + 1) - legStartDistances.at(i);
+    if(!(legLength > 0.f))
+      continue;
+
+    indexes.clear();
+    edgeIndex.getNearLineIndexes(indexes, Line(p1, p2), EPSILON_METER);
+
+    Vec a1 = Vec::fromPos(p1), a2 = Vec::fromPos(p2);
+    for(int index : indexes)
+    {
+      const AirspaceEdge& edge = edgeIndex.at(index);
+      if(!bandOverlaps(airspaces.at(edge.airspaceIndex)))
+        continue;
+
+      double fraction = arcIntersection(a1, a2, Vec::fromPos(edge.line.getPos1()), Vec::fromPos(edge.line.getPos2()),
+                                        lastLeg);
+      if(fraction >= 0.)
+        events.append({edge.airspaceIndex, i,
+                       legStartDistances.at(i) + static_cast<float>(fraction) * legLength});
+    }
+  }
+
+  // Airspaces containing the route start need no crossing
+  QVector<int> candidates;
+  for(int i = 0; i < airspaces.size(); i++)
+  {
+    const Airspace& airspace = airspaces.at(i);
+    if(bandOverlaps(airspace) && airspace.bounding.contains(route.first()))
+      candidates.append(i);
+  }
+  for(const Event& event : events)
+    candidates.append(event.airspaceIndex);
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+  std::sort(events.begin(), events.end(), [](const Event& e1, const Event& e2) -> bool {
+    return e1.airspaceIndex == e2.airspaceIndex ? e1.distanceMeter < e2.distanceMeter :
+           e1.airspaceIndex < e2.airspaceIndex;
+  });
+
+  // Build lateral penetrations and clip them by altitude ===========================
+  QVector<Event>::const_iterator eventIt = events.constBegin();
+  for(int airspaceIndex : candidates)
+  {
+    const Airspace& airspace = airspaces.at(airspaceIndex);
+
+    bool startsInside = airspace.bounding.contains(route.first()) && isInside(airspace, route.first());
+    bool inside = startsInside;
+    float enterDistance = 0.f;
+
+    while(eventIt != events.constEnd() && eventIt->airspaceIndex < airspaceIndex)
+      ++eventIt;
+
+    for(; eventIt != events.constEnd() && eventIt->airspaceIndex == airspaceIndex; ++eventIt)
+    {
+      float distance = eventIt->distanceMeter;
+
+      // Merge events at nearly the same position. This happens if a route point or a polygon vertex lies on
+      // the other line despite the half-open segments due to rounding errors or if the route touches the boundary.
+      int numEvents = 1;
+      while(eventIt + 1 != events.constEnd() && (eventIt + 1)->airspaceIndex == airspaceIndex &&
+            (eventIt + 1)->distanceMeter - distance < EPSILON_METER)
+      {
+        ++eventIt;
+        numEvents++;
+      }
+
+      bool nextInside = !inside;
+      if(numEvents > 1)
+      {
+        // Toggling is ambiguous - check the position halfway to the next event or the route end
+        float nextDistance = totalDistance;
+        if(eventIt + 1 != events.constEnd() && (eventIt + 1)->airspaceIndex == airspaceIndex)
+          nextDistance = (eventIt + 1)->distanceMeter;
+
+        int legIndex;
+        nextInside = isInside(airspace, routePos(route, legStartDistances, (distance + nextDistance) / 2.f, legIndex));
+      }
+
+      if(nextInside == inside)
+        // Touched boundary only
+        continue;
+
+      if(inside)
+        clipAltitude(crossings, airspace, route, legStartDistances, enterDistance, distance,
+                     enterDistance == 0.f && startsInside, false);
+      else
+        enterDistance = distance;
+      inside = nextInside;
+    }
+
+    if(inside)
+      clipAltitude(crossings, airspace, route, legStartDistances, enterDistance, totalDistance,
+                   enterDistance == 0.f && startsInside, true);
+  }
+
+  std::sort(crossings.begin(), crossings.end(), [](const AirspaceCrossing& c1, const AirspaceCrossing& c2) -> bool {
+    return c1.entryDistanceMeter < c2.entryDistanceMeter;
+  });
+}
+
+bool AirspaceCrossingIndex::isInside(const Airspace& airspace, const Pos& pos) const
+{
+  // Use a meridian from pos to a point outside of the bounding rectangle
+  Pos outside(pos.getLonX(), airspace.bounding.getNorth() + 1.f);
+  if(outside.getLatY() > 89.f)
+    outside.setLatY(airspace.bounding.getSouth() - 1.f);
+
+  Vec a1 = Vec::fromPos(pos), a2 = Vec::fromPos(outside);
+  int numCrossings = 0;
+  for(int i = airspace.firstEdge; i < airspace.firstEdge + airspace.numEdges; i++)
+  {
+    const Line& line = edgeIndex.at(i).line;
+    if(arcIntersection(a1, a2, Vec::fromPos(line.getPos1()), Vec::fromPos(line.getPos2()), true) >= 0.)
+      numCrossings++;
+  }
+  return numCrossings % 2 == 1;
+}
+
+void AirspaceCrossingIndex::clipAltitude(QVector<AirspaceCrossing>& crossings, const Airspace& airspace,
+                                         const LineString& route, const QVector<float>& legStartDistances,
+                                         float startDistance, float endDistance, bool startsInside,
+                                         bool endsInside) const
+{
+  float minAlt = static_cast<float>(airspace.minAltitudeFt), maxAlt = static_cast<float>(airspace.maxAltitudeFt);
+
+  // Adds a crossing for the given distances
+  auto addCrossing = [&](float from, float to) -> void {
+                       AirspaceCrossing crossing;
+                       crossing.boundaryId = airspace.boundaryId;
+                       crossing.entryDistanceMeter = from;
+                       crossing.exitDistanceMeter = to;
+                       crossing.entryPos = routePos(route, legStartDistances, from, crossing.entryLegIndex);
+                       crossing.exitPos = routePos(route, legStartDistances, to, crossing.exitLegIndex);
+                       crossing.entryVertical = from > startDistance + EPSILON_METER;
+                       crossing.exitVertical = to < endDistance - EPSILON_METER;
+                       crossing.startsInside = startsInside && !crossing.entryVertical;
+                       crossing.endsInside = endsInside && !crossing.exitVertical;
+                       crossings.append(crossing);
+                     };
+
+  bool open = false;
+  float openFrom = 0.f, openTo = 0.f;
+  int firstLeg = legIndexAt(legStartDistances, startDistance), lastLeg = legIndexAt(legStartDistances, endDistance);
+  for(int i = firstLeg; i <= lastLeg; i++)
+  {
+    float legFrom = legStartDistances.at(i), legTo = legStartDistances.at(i + 1);
+    float from = std::max(startDistance, legFrom), to = std::min(endDistance, legTo);
+    if(from > to)
+      continue;
+
+    // Get distance range inside the altitude band on this leg
+    float alt1 = route.at(i).getAltitude(), alt2 = route.at(i + 1).getAltitude();
+    float lo, hi;
+    if(legTo - legFrom > 0.f && std::abs(alt2 - alt1) > 0.f)
+    {
+      // Altitude changes linearly on leg
+      float slope = (alt2 - alt1) / (legTo - legFrom);
+      float dMin = legFrom + (minAlt - alt1) / slope, dMax = legFrom + (maxAlt - alt1) / slope;
+      lo = std::max(from, std::min(dMin, dMax));
+      hi = std::min(to, std::max(dMin, dMax));
+    }
+    else if(alt1 >= minAlt && alt1 <= maxAlt)
+    {
+      lo = from;
+      hi = to;
+    }
+    else
+      continue;
+
+    if(lo > hi)
+      continue;
+
+    if(open && lo <= openTo + EPSILON_METER)
+      // Continues on this leg
+      openTo = hi;
+    else
+    {
+      if(open)
+        addCrossing(openFrom, openTo);
+      open = true;
+      openFrom = lo;
+      openTo = hi;
+    }
+  }
+
+  if(open)
+    addCrossing(openFrom, openTo);
+}
+
+Pos AirspaceCrossingIndex::routePos(const LineString& route, const QVector<float>& legStartDistances,
+                                    float distanceMeter, int& legIndex) const
+{
+  legIndex = legIndexAt(legStartDistances, distanceMeter);
+  float legLength = legStartDistances.at(legIndex + 1) - legStartDistances.at(legIndex);
+  float fraction = legLength > 0.f ? (distanceMeter - legStartDistances.at(legIndex)) / legLength : 0.f;
+  fraction = std::max(0.f, std::min(fraction, 1.f));
+
+  const Pos& p1 = route.at(legIndex);
+  const Pos& p2 = route.at(legIndex + 1);
+  Pos pos = p1.interpolate(p2, legLength, fraction);
+  pos.setAltitude(p1.getAltitude() + (p2.getAltitude() - p1.getAltitude()) * fraction);
+  return pos;
+}
+
+QDebug operator<<(QDebug out, const AirspaceCrossing& obj)
+{
+  QDebugStateSaver saver(out);
+
+  out.nospace().noquote() << "AirspaceCrossing("
+                          << "id " << obj.boundaryId
+                          << ", entry leg " << obj.entryLegIndex
+                          << ", entry " << obj.entryDistanceMeter
+                          << ", " << obj.entryPos
+                          << ", vertical " << obj.entryVertical
+                          << ", starts inside " << obj.startsInside
+                          << ", exit leg " << obj.exitLegIndex
+                          << ", exit " << obj.exitDistanceMeter
+                          << ", " << obj.exitPos
+                          << ", vertical " << obj.exitVertical
+                          << ", ends inside " << obj.endsInside
+                          << ")";
+  return out;
+}
+
+} // namespace common
+} // namespace fs
+} // namespace atools
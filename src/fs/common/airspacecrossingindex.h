@@ -0,0 +1,166 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_COMMON_AIRSPACECROSSINGINDEX_H
+#define ATOOLS_FS_COMMON_AIRSPACECROSSINGINDEX_H
+
+#include "geo/segmentspatialindex.h"
+#include "geo/rect.h"
+
+#include <QStringList>
+
+namespace atools {
+namespace geo {
+class LineString;
+}
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace common {
+
+/* One penetration of an airspace by a route. An airspace can be entered more than once. */
+struct AirspaceCrossing
+{
+  int boundaryId = -1; /* Value of boundary.boundary_id or id given in AirspaceCrossingIndex::addAirspace() */
+
+  /* Index of the route leg where the airspace is entered or left. Leg 0 is from route point 0 to point 1. */
+  int entryLegIndex = -1, exitLegIndex = -1;
+
+  /* Distance from route start */
+  float entryDistanceMeter = 0.f, exitDistanceMeter = 0.f;
+
+  /* Positions including altitude in feet */
+  atools::geo::Pos entryPos, exitPos;
+
+  /* true if airspace is entered or left by climbing or descending through the altitude limits and not
+   * by crossing the lateral boundary */
+  bool entryVertical = false, exitVertical = false;
+
+  /* true if route starts or ends inside the airspace */
+  bool startsInside = false, endsInside = false;
+
+  bool isValid() const
+  {
+    return boundaryId != -1;
+  }
+
+  friend QDebug operator<<(QDebug out, const atools::fs::common::AirspaceCrossing& obj);
+
+};
+
+/*
+ * Finds all airspaces penetrated by a route with an altitude profile.
+ *
+ * All polygon edges of all airspaces are kept in a segment spatial index which is used to get
+ * candidate edges for each route leg. Route legs and airspace edges are treated as great circle lines
+ * and intersected exactly. Crossings are then clipped against the altitude band of each airspace.
+ *
+ * Airspaces can be read from the boundary table or added manually. Lookup is thread safe after loading.
+ */
+class AirspaceCrossingIndex
+{
+public:
+  AirspaceCrossingIndex();
+  ~AirspaceCrossingIndex();
+
+  AirspaceCrossingIndex(const AirspaceCrossingIndex& other) = delete;
+  AirspaceCrossingIndex& operator=(const AirspaceCrossingIndex& other) = delete;
+
+  /* Read all airspaces from table "boundary" and build the index.
+   * types is an optional list of values for column "type", e.g. "C" or "R". Empty loads all.
+   * Upper limits of type "UL" are unlimited. AGL limits are used as MSL since terrain elevation is not known,
+   * so crossings of airspaces with an AGL upper limit above high terrain can be missed.
+   * Returns false if table does not exist or is empty. */
+  bool readFromTable(atools::sql::SqlDatabase *db, const QStringList& types = QStringList());
+
+  /* Add a closed or open polygon. Altitudes are in feet. Call build() after adding all airspaces. */
+  void addAirspace(int boundaryId, const atools::geo::LineString& polygon, int minAltitudeFt, int maxAltitudeFt);
+
+  /* Build the edge index after adding airspaces */
+  void build();
+
+  void clear();
+
+  bool isEmpty() const
+  {
+    return airspaces.isEmpty();
+  }
+
+  int size() const
+  {
+    return airspaces.size();
+  }
+
+  /* Find all penetrated airspaces for the route. Route positions need the altitude in feet which is
+   * interpolated linearly by distance along each leg.
+   * Crossings are sorted by entry distance which keeps crossings of the same airspace in flying order. */
+  void findCrossings(QVector<atools::fs::common::AirspaceCrossing>& crossings,
+                     const atools::geo::LineString& route) const;
+
+private:
+  /* Airspace polygon edge as stored in the spatial index */
+  struct AirspaceEdge
+  {
+    atools::geo::Line line;
+    int airspaceIndex = -1;
+
+    const atools::geo::Line& getLine() const
+    {
+      return line;
+    }
+
+  };
+
+  struct Airspace
+  {
+    int boundaryId, minAltitudeFt, maxAltitudeFt;
+    atools::geo::Rect bounding;
+    int firstEdge, numEdges; /* Edges in the spatial index */
+  };
+
+  /* Airspace edge hit by a route leg */
+  struct Event
+  {
+    int airspaceIndex, legIndex;
+    float distanceMeter;
+  };
+
+  /* Check if pos is inside polygon by counting crossings of a line leaving the bounding rectangle */
+  bool isInside(const Airspace& airspace, const atools::geo::Pos& pos) const;
+
+  /* Clip lateral penetration between start and end distance against the altitude band */
+  void clipAltitude(QVector<atools::fs::common::AirspaceCrossing>& crossings, const Airspace& airspace,
+                    const atools::geo::LineString& route, const QVector<float>& legStartDistances,
+                    float startDistance, float endDistance, bool startsInside, bool endsInside) const;
+
+  /* Get position including altitude at distance from start */
+  atools::geo::Pos routePos(const atools::geo::LineString& route, const QVector<float>& legStartDistances,
+                            float distanceMeter, int& legIndex) const;
+
+  QVector<Airspace> airspaces;
+  atools::geo::SegmentSpatialIndex<AirspaceEdge> edgeIndex;
+};
+
+} // namespace common
+} // namespace fs
+} // namespace atools
+
+Q_DECLARE_TYPEINFO(atools::fs::common::AirspaceCrossing, Q_MOVABLE_TYPE);
+
+#endif // ATOOLS_FS_COMMON_AIRSPACECROSSINGINDEX_H
@@ -18,11 +18,24 @@
 #include "fs/common/binarygeometry.h"
 
 #include <QDataStream>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
 
 namespace atools {
 namespace fs {
 namespace common {
 
+/* QDataStream uses big endian byte order by default */
+inline static float readFloat(const uchar *data)
+{
+  quint32 value = qFromBigEndian<quint32>(data);
+  float retval;
+  memcpy(&retval, &value, sizeof(retval));
+  return retval;
+}
+
 BinaryGeometry::BinaryGeometry(const geo::LineString& value)
   : geometry(value)
 {
@@ -42,18 +55,45 @@ BinaryGeometry::BinaryGeometry()
 void BinaryGeometry::readFromByteArray(const QByteArray& bytes)
 {
   geometry.clear();
+  appendPositions(geometry, bytes);
+}
+
+void BinaryGeometry::readFromByteArrays(GeometryBuffer& buffer, const QVector<QByteArray>& bytesList)
+{
+  buffer.clear();
+  buffer.offsets.reserve(bytesList.size() + 1);
+
+  // Avoid reallocations - size prefix is four bytes and each position eight bytes
+  int totalSize = 0;
+  for(const QByteArray& bytes : bytesList)
+    totalSize += std::max(bytes.size() - 4, 0) / 8;
+  buffer.positions.reserve(totalSize);
+
+  for(const QByteArray& bytes : bytesList)
+  {
+    buffer.offsets.append(buffer.positions.size());
+    appendPositions(buffer.positions, bytes);
+  }
+  buffer.offsets.append(buffer.positions.size());
+}
+
+void BinaryGeometry::appendPositions(QVector<geo::Pos>& positions, const QByteArray& bytes)
+{
+  if(bytes.size() < 4)
+    return;
 
-  QDataStream in(bytes);
-  in.setVersion(QDataStream::Qt_5_5);
-  in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+  // Format written by QDataStream: quint32 number of positions followed by pairs of single precision floats
+  const uchar *data = reinterpret_cast<const uchar *>(bytes.constData());
+  quint32 size = std::min(qFromBigEndian<quint32>(data), static_cast<quint32>(bytes.size() - 4) / 8);
+  data += 4;
 
-  quint32 size;
-  float lonx, laty;
-  in >> size;
-  for(unsigned int i = 0; i < size; i++)
+  int start = positions.size();
+  positions.resize(start + static_cast<int>(size));
+  atools::geo::Pos *dest = positions.data() + start;
+  for(quint32 i = 0; i < size; i++)
   {
-    in >> lonx >> laty;
-    geometry.append(lonx, laty);
+    dest[i] = atools::geo::Pos(readFloat(data), readFloat(data + 4));
+    data += 8;
   }
 }
 
@@ -26,6 +26,58 @@ namespace atools {
 namespace fs {
 namespace common {
 
+/*
+ * Many geometries decoded into one contiguous position buffer with an offset array.
+ * Filled by BinaryGeometry::readFromByteArrays(). Memory is kept when reusing the buffer.
+ */
+struct GeometryBuffer
+{
+  /* Positions of all geometries */
+  QVector<atools::geo::Pos> positions;
+
+  /* Start index in positions for each geometry followed by the end index of the last one */
+  QVector<int> offsets;
+
+  /* Number of geometries */
+  int size() const
+  {
+    return offsets.isEmpty() ? 0 : offsets.size() - 1;
+  }
+
+  /* Number of positions in geometry */
+  int geometrySize(int index) const
+  {
+    return offsets.at(index + 1) - offsets.at(index);
+  }
+
+  const atools::geo::Pos *geometryBegin(int index) const
+  {
+    return positions.constData() + offsets.at(index);
+  }
+
+  const atools::geo::Pos *geometryEnd(int index) const
+  {
+    return positions.constData() + offsets.at(index + 1);
+  }
+
+  /* Copy geometry into line string */
+  void getGeometry(atools::geo::LineString& line, int index) const
+  {
+    line.clear();
+    line.reserve(geometrySize(index));
+    for(const atools::geo::Pos *pos = geometryBegin(index); pos != geometryEnd(index); ++pos)
+      line.append(*pos);
+  }
+
+  /* Remove all geometries but keep allocated memory */
+  void clear()
+  {
+    positions.resize(0);
+    offsets.resize(0);
+  }
+
+};
+
 /*
  * FSX/P3D geometry for common use in database and client code.
  *
@@ -46,6 +98,10 @@ public:
   void readFromByteArray(const QByteArray& bytes);
   QByteArray writeToByteArray();
 
+  /* Decode a list of byte arrays into the buffer which is cleared before.
+   * Positions are decoded directly from the bytes without using a stream or allocating per geometry. */
+  static void readFromByteArrays(atools::fs::common::GeometryBuffer& buffer, const QVector<QByteArray>& bytesList);
+
   const atools::geo::LineString& getGeometry() const
   {
     return geometry;
@@ -62,6 +118,9 @@ public:
   }
 
 private:
+  /* Decode bytes and append positions. Truncated arrays are read up to the last complete position. */
+  static void appendPositions(QVector<atools::geo::Pos>& positions, const QByteArray& bytes);
+
   atools::geo::LineString geometry;
 };
 
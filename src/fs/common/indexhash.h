@@ -0,0 +1,187 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_COMMON_INDEXHASH_H
+#define ATOOLS_FS_COMMON_INDEXHASH_H
+
+#include <QVector>
+
+namespace atools {
+namespace fs {
+namespace common {
+
+/*
+ * Compact hash map from small fixed size keys to int values. Used for the large indexes filled while
+ * compiling the scenery database.
+ *
+ * Uses open addressing with linear probing. Keys and values are kept in dense arrays in insertion order and the
+ * probe table holds only indexes into these. This needs a fraction of the memory and allocations of a QHash
+ * and keeps probing cache friendly. Entries cannot be removed except by clearing the whole index.
+ *
+ * KEY needs operator== and a well distributed qHash() since the lower bits are used for the table position.
+ */
+template<typename KEY>
+class IndexHash
+{
+public:
+  /* Insert or replace value for key */
+  void insert(const KEY& key, int value);
+
+  /* Insert value only if key is not already present. Returns true if inserted. */
+  bool insertNew(const KEY& key, int value);
+
+  /* Get value or defaultValue if not found */
+  int value(const KEY& key, int defaultValue = -1) const
+  {
+    int index = findIndex(key);
+    return index != -1 ? values.at(index) : defaultValue;
+  }
+
+  bool contains(const KEY& key) const
+  {
+    return findIndex(key) != -1;
+  }
+
+  int size() const
+  {
+    return keys.size();
+  }
+
+  bool isEmpty() const
+  {
+    return keys.isEmpty();
+  }
+
+  /* Prepare for number of entries to avoid rehashing */
+  void reserve(int size);
+
+  void clear()
+  {
+    keys.clear();
+    values.clear();
+    table.clear();
+  }
+
+  /* Approximate memory used in bytes */
+  qint64 memorySize() const
+  {
+    return keys.capacity() * static_cast<qint64>(sizeof(KEY)) +
+           values.capacity() * static_cast<qint64>(sizeof(int)) +
+           table.capacity() * static_cast<qint64>(sizeof(int));
+  }
+
+private:
+  /* Initial table size. Load factor is kept below 0.5 which keeps probe sequences short. */
+  static Q_DECL_CONSTEXPR int MIN_TABLE_SIZE = 64;
+
+  /* Index in keys and values or -1 if not found */
+  int findIndex(const KEY& key) const;
+
+  /* Table position which is either empty or contains key */
+  int findSlot(const KEY& key) const;
+
+  void rehash(int tableSize);
+
+  QVector<KEY> keys;
+  QVector<int> values;
+
+  /* 0 if empty or index + 1 into keys and values. Size is a power of two. */
+  QVector<int> table;
+};
+
+// ==================================================================================
+template<typename KEY>
+void IndexHash<KEY>::insert(const KEY& key, int value)
+{
+  if(!insertNew(key, value))
+    values[table.at(findSlot(key)) - 1] = value;
+}
+
+template<typename KEY>
+bool IndexHash<KEY>::insertNew(const KEY& key, int value)
+{
+  if((keys.size() + 1) * 2 > table.size())
+    rehash(table.isEmpty() ? MIN_TABLE_SIZE : table.size() * 2);
+
+  int slot = findSlot(key);
+  if(table.at(slot) != 0)
+    return false;
+
+  keys.append(key);
+  values.append(value);
+  table[slot] = keys.size();
+  return true;
+}
+
+template<typename KEY>
+void IndexHash<KEY>::reserve(int size)
+{
+  keys.reserve(size);
+  values.reserve(size);
+
+  int tableSize = MIN_TABLE_SIZE;
+  while(tableSize < size * 2)
+    tableSize *= 2;
+
+  if(tableSize > table.size())
+    rehash(tableSize);
+}
+
+template<typename KEY>
+int IndexHash<KEY>::findIndex(const KEY& key) const
+{
+  if(table.isEmpty())
+    return -1;
+
+  return table.at(findSlot(key)) - 1;
+}
+
+template<typename KEY>
+int IndexHash<KEY>::findSlot(const KEY& key) const
+{
+  int mask = table.size() - 1;
+  int slot = static_cast<int>(qHash(key)) & mask;
+  const int *tableData = table.constData();
+  const KEY *keyData = keys.constData();
+
+  // Table is never full - loop will always end at an empty slot
+  while(tableData[slot] != 0 && !(keyData[tableData[slot] - 1] == key))
+    slot = (slot + 1) & mask;
+
+  return slot;
+}
+
+template<typename KEY>
+void IndexHash<KEY>::rehash(int tableSize)
+{
+  table.fill(0, tableSize);
+
+  int mask = tableSize - 1;
+  for(int i = 0; i < keys.size(); i++)
+  {
+    int slot = static_cast<int>(qHash(keys.at(i))) & mask;
+    while(table.at(slot) != 0)
+      slot = (slot + 1) & mask;
+    table[slot] = i + 1;
+  }
+}
+
+} // namespace common
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_COMMON_INDEXHASH_H
@@ -0,0 +1,354 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/common/navsnapshot.h"
+
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlutil.h"
+#include "geo/rect.h"
+#include "exception.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cstring>
+
+namespace atools {
+namespace fs {
+namespace common {
+
+using atools::sql::SqlDatabase;
+using atools::sql::SqlQuery;
+using atools::geo::Rect;
+
+static const char MAGIC[8] = {'A', 'T', 'N', 'A', 'V', 'S', '0', '1'};
+static const quint32 BYTE_ORDER_MARK = 0x01020304;
+
+/* Grid of two by two degree cells */
+static const float CELL_SIZE = 2.f;
+static const int GRID_WIDTH = 180, GRID_HEIGHT = 90, NUM_CELLS = GRID_WIDTH * GRID_HEIGHT;
+
+/* Queries for all tables in order of enum Table. Columns are id, lonx, laty, ident, type and value. */
+static const char *TABLE_QUERIES[NavSnapshot::NUM_TABLES] =
+{
+  "select airport_id, lonx, laty, ident, null as type, "
+  "  is_closed | (is_military << 1) | (is_addon << 2) | ((num_runway_hard > 0) << 3) | "
+  "  ((num_runway_soft > 0) << 4) | ((num_runway_water > 0) << 5) | ((num_helipad > 0) << 6) | "
+  "  (coalesce(longest_runway_length, 0) << 8) as value "
+  "from airport",
+  "select vor_id, lonx, laty, ident, type, frequency as value from vor",
+  "select ndb_id, lonx, laty, ident, type, frequency as value from ndb",
+  "select waypoint_id, lonx, laty, ident, type, num_victor_airway | (num_jet_airway << 16) as value from waypoint"
+};
+
+static const char *TABLE_NAMES[NavSnapshot::NUM_TABLES] = {"airport", "vor", "ndb", "waypoint"};
+
+struct FileHeader
+{
+  char magic[8];
+  quint32 byteOrder, numTables;
+  char key[128];
+  quint64 fileSize;
+};
+
+/* Offsets of columns in file */
+struct TableHeader
+{
+  quint32 numRows, reserved;
+  quint64 cellOffset, idOffset, lonxOffset, latyOffset, identOffset, typeOffset, valueOffset;
+};
+
+static int cellX(float lonx)
+{
+  return std::max(0, std::min(static_cast<int>((lonx + 180.f) / CELL_SIZE), GRID_WIDTH - 1));
+}
+
+static int cellY(float laty)
+{
+  return std::max(0, std::min(static_cast<int>((laty + 90.f) / CELL_SIZE), GRID_HEIGHT - 1));
+}
+
+/* Copy string into fixed size field padded with null bytes */
+static void packString(char *dest, const QString& str)
+{
+  QByteArray latin = str.toLatin1();
+  memset(dest, 0, NavSnapshot::PACKED_SIZE);
+  int size = latin.size() < NavSnapshot::PACKED_SIZE ? latin.size() : NavSnapshot::PACKED_SIZE;
+  memcpy(dest, latin.constData(), static_cast<size_t>(size));
+}
+
+/* Append data to buffer aligned to eight bytes and return offset */
+static quint64 appendAligned(QByteArray& buffer, const char *data, int size)
+{
+  while(buffer.size() % 8 != 0)
+    buffer.append('\0');
+  quint64 offset = static_cast<quint64>(buffer.size());
+  buffer.append(data, size);
+  return offset;
+}
+
+NavSnapshot::NavSnapshot()
+{
+
+}
+
+NavSnapshot::~NavSnapshot()
+{
+  close();
+}
+
+QByteArray NavSnapshot::databaseKey(SqlDatabase *db)
+{
+  QByteArray key;
+  SqlQuery query("select last_load_timestamp, data_source, airac_cycle, compiler_version from metadata", db);
+  query.exec();
+  if(query.next())
+    key = QCryptographicHash::hash((query.valueStr(0) + "|" + query.valueStr(1) + "|" + query.valueStr(2) + "|" +
+                                    query.valueStr(3)).toUtf8(), QCryptographicHash::Sha1).toHex();
+  return key;
+}
+
+void NavSnapshot::write(SqlDatabase *db, const QString& filename)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  struct Row
+  {
+    int cell;
+    qint32 id;
+    float lonx, laty;
+    char ident[PACKED_SIZE], type[PACKED_SIZE];
+    quint32 value;
+  };
+
+  QByteArray key = databaseKey(db);
+
+  // Header and table headers are written last
+  QByteArray buffer(static_cast<int>(sizeof(FileHeader) + sizeof(TableHeader) * NUM_TABLES), '\0');
+  TableHeader tableHeaders[NUM_TABLES];
+  memset(tableHeaders, 0, sizeof(tableHeaders));
+
+  for(int t = 0; t < NUM_TABLES; t++)
+  {
+    // Read and sort rows by cell ======================================
+    QVector<Row> rows;
+    rows.reserve(atools::sql::SqlUtil(db).rowCount(TABLE_NAMES[t]));
+
+    SqlQuery query(TABLE_QUERIES[t], db);
+    query.exec();
+    while(query.next())
+    {
+      Row row;
+      row.id = query.valueInt(0);
+      row.lonx = query.valueFloat(1);
+      row.laty = query.valueFloat(2);
+      row.cell = cellY(row.laty) * GRID_WIDTH + cellX(row.lonx);
+      packString(row.ident, query.valueStr(3));
+      packString(row.type, query.isNull(4) ? QString() : query.valueStr(4));
+      row.value = static_cast<quint32>(query.valueInt(5));
+      rows.append(row);
+    }
+
+    std::sort(rows.begin(), rows.end(), [](const Row& r1, const Row& r2) -> bool
+          {
+            return r1.cell == r2.cell ? r1.id < r2.id : r1.cell < r2.cell;
+          });
+
+    // Build columns ======================================
+    int num = rows.size();
+    QVector<quint32> cells(NUM_CELLS + 1, 0);
+    QVector<qint32> ids(num);
+    QVector<float> lonx(num), laty(num);
+    QByteArray idents(num * PACKED_SIZE, '\0'), types(num * PACKED_SIZE, '\0');
+    QVector<quint32> values(num);
+
+    for(int i = 0; i < num; i++)
+    {
+      const Row& row = rows.at(i);
+      cells[row.cell + 1]++;
+      ids[i] = row.id;
+      lonx[i] = row.lonx;
+      laty[i] = row.laty;
+      memcpy(idents.data() + i * PACKED_SIZE, row.ident, PACKED_SIZE);
+      memcpy(types.data() + i * PACKED_SIZE, row.type, PACKED_SIZE);
+      values[i] = row.value;
+    }
+
+    // Convert counts to start index of each cell
+    for(int i = 1; i <= NUM_CELLS; i++)
+      cells[i] += cells[i - 1];
+
+    TableHeader& header = tableHeaders[t];
+    header.numRows = static_cast<quint32>(num);
+    header.cellOffset = appendAligned(buffer, reinterpret_cast<const char *>(cells.constData()),
+                                      cells.size() * static_cast<int>(sizeof(quint32)));
+    header.idOffset = appendAligned(buffer, reinterpret_cast<const char *>(ids.constData()),
+                                    num * static_cast<int>(sizeof(qint32)));
+    header.lonxOffset = appendAligned(buffer, reinterpret_cast<const char *>(lonx.constData()),
+                                      num * static_cast<int>(sizeof(float)));
+    header.latyOffset = appendAligned(buffer, reinterpret_cast<const char *>(laty.constData()),
+                                      num * static_cast<int>(sizeof(float)));
+    header.identOffset = appendAligned(buffer, idents.constData(), idents.size());
+    header.typeOffset = appendAligned(buffer, types.constData(), types.size());
+    header.valueOffset = appendAligned(buffer, reinterpret_cast<const char *>(values.constData()),
+                                       num * static_cast<int>(sizeof(quint32)));
+  }
+
+  // Fill headers ======================================
+  FileHeader fileHeader;
+  memset(&fileHeader, 0, sizeof(fileHeader));
+  memcpy(fileHeader.magic, MAGIC, sizeof(MAGIC));
+  fileHeader.byteOrder = BYTE_ORDER_MARK;
+  fileHeader.numTables = NUM_TABLES;
+  memcpy(fileHeader.key, key.constData(), static_cast<size_t>(std::min(key.size(), 127)));
+  fileHeader.fileSize = static_cast<quint64>(buffer.size());
+
+  memcpy(buffer.data(), &fileHeader, sizeof(FileHeader));
+  memcpy(buffer.data() + sizeof(FileHeader), tableHeaders, sizeof(tableHeaders));
+
+  QSaveFile out(filename);
+  if(!out.open(QIODevice::WriteOnly) || out.write(buffer) != buffer.size() || !out.commit())
+    throw atools::Exception(QObject::tr("Cannot write file \"%1\". Reason: %2.").
+                            arg(filename).arg(out.errorString()));
+
+  qDebug() << Q_FUNC_INFO << filename << buffer.size() << "bytes" << timer.elapsed() << "ms";
+}
+
+bool NavSnapshot::open(const QString& filename, const QByteArray& key)
+{
+  close();
+
+  file.setFileName(filename);
+  if(!file.open(QIODevice::ReadOnly))
+    return false;
+
+  qint64 fileSize = file.size();
+  if(fileSize < static_cast<qint64>(sizeof(FileHeader) + sizeof(TableHeader) * NUM_TABLES))
+  {
+    qWarning() << Q_FUNC_INFO << filename << "too small";
+    close();
+    return false;
+  }
+
+  data = file.map(0, fileSize);
+  if(data == nullptr)
+  {
+    qWarning() << Q_FUNC_INFO << filename << "cannot map" << file.errorString();
+    close();
+    return false;
+  }
+
+  // Check header ===============================
+  const FileHeader *fileHeader = reinterpret_cast<const FileHeader *>(data);
+  if(memcmp(fileHeader->magic, MAGIC, sizeof(MAGIC)) != 0 || fileHeader->byteOrder != BYTE_ORDER_MARK ||
+     fileHeader->numTables != NUM_TABLES || fileHeader->fileSize != static_cast<quint64>(fileSize))
+  {
+    qWarning() << Q_FUNC_INFO << filename << "invalid header";
+    close();
+    return false;
+  }
+
+  if(QByteArray(fileHeader->key, static_cast<int>(qstrnlen(fileHeader->key, sizeof(fileHeader->key)))) != key)
+  {
+    qInfo() << Q_FUNC_INFO << filename << "does not match database";
+    close();
+    return false;
+  }
+
+  // Assign column pointers ===============================
+  const TableHeader *tableHeaders = reinterpret_cast<const TableHeader *>(data + sizeof(FileHeader));
+  for(int t = 0; t < NUM_TABLES; t++)
+  {
+    const TableHeader *header = &tableHeaders[t];
+    quint64 num = header->numRows;
+
+    // Check that all columns are inside the file
+    if(header->cellOffset + (NUM_CELLS + 1) * sizeof(quint32) > fileHeader->fileSize ||
+       header->idOffset + num * sizeof(qint32) > fileHeader->fileSize ||
+       header->lonxOffset + num * sizeof(float) > fileHeader->fileSize ||
+       header->latyOffset + num * sizeof(float) > fileHeader->fileSize ||
+       header->identOffset + num * PACKED_SIZE > fileHeader->fileSize ||
+       header->typeOffset + num * PACKED_SIZE > fileHeader->fileSize ||
+       header->valueOffset + num * sizeof(quint32) > fileHeader->fileSize)
+    {
+      qWarning() << Q_FUNC_INFO << filename << "invalid table" << TABLE_NAMES[t];
+      close();
+      return false;
+    }
+
+    TableData& table = tables[t];
+    table.numRows = static_cast<int>(header->numRows);
+    table.cells = reinterpret_cast<const quint32 *>(data + header->cellOffset);
+    table.ids = reinterpret_cast<const qint32 *>(data + header->idOffset);
+    table.lonx = reinterpret_cast<const float *>(data + header->lonxOffset);
+    table.laty = reinterpret_cast<const float *>(data + header->latyOffset);
+    table.idents = reinterpret_cast<const char *>(data + header->identOffset);
+    table.types = reinterpret_cast<const char *>(data + header->typeOffset);
+    table.values = reinterpret_cast<const quint32 *>(data + header->valueOffset);
+  }
+
+  qDebug() << Q_FUNC_INFO << filename << "opened";
+  return true;
+}
+
+void NavSnapshot::close()
+{
+  if(data != nullptr)
+  {
+    file.unmap(data);
+    data = nullptr;
+  }
+  file.close();
+
+  for(int t = 0; t < NUM_TABLES; t++)
+    tables[t] = TableData();
+}
+
+void NavSnapshot::query(QVector<int>& rows, Table table, const Rect& rect) const
+{
+  if(!isOpen() || !rect.isValid())
+    return;
+
+  const TableData& tableData = tables[table];
+
+  for(const Rect& r : rect.splitAtAntiMeridian())
+  {
+    float west = r.getWest(), east = r.getEast(), north = r.getNorth(), south = r.getSouth();
+    int x1 = cellX(west), x2 = cellX(east), y1 = cellY(south), y2 = cellY(north);
+
+    for(int y = y1; y <= y2; y++)
+    {
+      // Cells of one grid row are stored consecutively
+      quint32 begin = tableData.cells[y * GRID_WIDTH + x1], end = tableData.cells[y * GRID_WIDTH + x2 + 1];
+      for(quint32 i = begin; i < end; i++)
+      {
+        float lonx = tableData.lonx[i], laty = tableData.laty[i];
+        if(lonx >= west && lonx <= east && laty >= south && laty <= north)
+          rows.append(static_cast<int>(i));
+      }
+    }
+  }
+}
+
+} // namespace common
+} // namespace fs
+} // namespace atools
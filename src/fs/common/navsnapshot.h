@@ -0,0 +1,166 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_COMMON_NAVSNAPSHOT_H
+#define ATOOLS_FS_COMMON_NAVSNAPSHOT_H
+
+#include "geo/pos.h"
+
+#include <QFile>
+#include <QLatin1String>
+
+namespace atools {
+namespace geo {
+class Rect;
+}
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace common {
+
+/*
+ * Read-only columnar copy of the columns of airport, vor, ndb and waypoint which are needed for map display.
+ *
+ * The snapshot is written to a sidecar file after compiling the database and is memory mapped when reading.
+ * Rows are sorted into a grid of two by two degree cells and each column is stored as a plain array.
+ * A viewport query reads only the rows of the covered cells and does not use SQL or QVariant.
+ *
+ * The file contains a key built from the database metadata. open() fails if the key does not match.
+ * The file uses the native byte order and is not portable between platforms with different endianness.
+ */
+class NavSnapshot
+{
+public:
+  enum Table
+  {
+    AIRPORT,
+    VOR,
+    NDB,
+    WAYPOINT,
+    NUM_TABLES
+  };
+
+  /* Flags in the lower eight bits of getValue() for airports. Upper bits contain longest runway length in feet. */
+  enum AirportFlag
+  {
+    AP_CLOSED = 1 << 0,
+    AP_MILITARY = 1 << 1,
+    AP_ADDON = 1 << 2,
+    AP_HARD = 1 << 3,
+    AP_SOFT = 1 << 4,
+    AP_WATER = 1 << 5,
+    AP_HELIPAD = 1 << 6
+  };
+
+  NavSnapshot();
+  ~NavSnapshot();
+
+  NavSnapshot(const NavSnapshot& other) = delete;
+  NavSnapshot& operator=(const NavSnapshot& other) = delete;
+
+  /* Write snapshot for database. Throws atools::Exception on error. */
+  static void write(atools::sql::SqlDatabase *db, const QString& filename);
+
+  /* Key identifying a compiled database which is built from the metadata table */
+  static QByteArray databaseKey(atools::sql::SqlDatabase *db);
+
+  /* Sidecar filename for database file */
+  static QString snapshotFilename(const QString& databaseFilename)
+  {
+    return databaseFilename + ".navsnapshot";
+  }
+
+  /* Map file. Returns false if file does not exist, is invalid or does not match the database key. */
+  bool open(const QString& filename, const QByteArray& key);
+  void close();
+
+  bool isOpen() const
+  {
+    return data != nullptr;
+  }
+
+  /* Appends indexes of all rows in table which are inside rect */
+  void query(QVector<int>& rows, atools::fs::common::NavSnapshot::Table table,
+             const atools::geo::Rect& rect) const;
+
+  /* Number of rows in table */
+  int size(atools::fs::common::NavSnapshot::Table table) const
+  {
+    return tables[table].numRows;
+  }
+
+  /* Database id, i.e. airport_id or waypoint_id */
+  int getId(atools::fs::common::NavSnapshot::Table table, int row) const
+  {
+    return tables[table].ids[row];
+  }
+
+  atools::geo::Pos getPosition(atools::fs::common::NavSnapshot::Table table, int row) const
+  {
+    return atools::geo::Pos(tables[table].lonx[row], tables[table].laty[row]);
+  }
+
+  QLatin1String getIdent(atools::fs::common::NavSnapshot::Table table, int row) const
+  {
+    return packedString(tables[table].idents + row * PACKED_SIZE);
+  }
+
+  /* Column type for navaids. Empty for airports. */
+  QLatin1String getType(atools::fs::common::NavSnapshot::Table table, int row) const
+  {
+    return packedString(tables[table].types + row * PACKED_SIZE);
+  }
+
+  /* Airport: flags and runway length, see AirportFlag. VOR and NDB: frequency.
+   * Waypoint: number of victor airways in lower and number of jet airways in upper 16 bits. */
+  quint32 getValue(atools::fs::common::NavSnapshot::Table table, int row) const
+  {
+    return tables[table].values[row];
+  }
+
+  /* Size of packed ident and type strings. Longer strings are truncated. */
+  static Q_DECL_CONSTEXPR int PACKED_SIZE = 8;
+
+private:
+  /* Pointers into the mapped file */
+  struct TableData
+  {
+    int numRows = 0;
+    const quint32 *cells = nullptr;
+    const qint32 *ids = nullptr;
+    const float *lonx = nullptr, *laty = nullptr;
+    const char *idents = nullptr, *types = nullptr;
+    const quint32 *values = nullptr;
+  };
+
+  static QLatin1String packedString(const char *str)
+  {
+    return QLatin1String(str, static_cast<int>(qstrnlen(str, PACKED_SIZE)));
+  }
+
+  QFile file;
+  uchar *data = nullptr;
+  TableData tables[NUM_TABLES];
+};
+
+} // namespace common
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_COMMON_NAVSNAPSHOT_H
@@ -18,6 +18,10 @@
 #include "fs/common/xpgeometry.h"
 
 #include <QDataStream>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
 
 using atools::geo::Pos;
 
@@ -25,6 +29,15 @@ namespace atools {
 namespace fs {
 namespace common {
 
+/* QDataStream uses big endian byte order by default */
+inline static float readFloat(const uchar *data)
+{
+  quint32 value = qFromBigEndian<quint32>(data);
+  float retval;
+  memcpy(&retval, &value, sizeof(retval));
+  return retval;
+}
+
 XpGeometry::XpGeometry(const QByteArray& bytes)
 {
   readFromByteArray(bytes);
@@ -52,30 +65,47 @@ void XpGeometry::readFromByteArray(const QByteArray& bytes)
 {
   clear();
 
-  QDataStream in(bytes);
-  in.setVersion(QDataStream::Qt_5_5);
-  in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+  // Format written by QDataStream: quint32 number of boundary nodes, nodes, quint16 number of holes and
+  // for each hole quint32 number of nodes followed by the nodes
+  const uchar *data = reinterpret_cast<const uchar *>(bytes.constData());
+  const uchar *end = data + bytes.size();
+
+  if(end - data < 4)
+    return;
+  quint32 numNodes = qFromBigEndian<quint32>(data);
+  data += 4;
 
-  quint32 numNodes;
-  quint16 numHoles;
-  in >> numNodes;
+  // At least nine bytes per node - avoid reserving huge sizes for broken blobs
+  geometry.boundary.reserve(static_cast<int>(std::min(numNodes, static_cast<quint32>(end - data) / 9)));
   for(quint32 i = 0; i < numNodes; i++)
   {
     Node node;
-    readNode(in, node);
+    if(!readNode(data, end, node))
+      return;
     geometry.boundary.append(node);
   }
 
-  in >> numHoles;
+  if(end - data < 2)
+    return;
+  quint16 numHoles = qFromBigEndian<quint16>(data);
+  data += 2;
+
   for(quint16 i = 0; i < numHoles; i++)
   {
+    if(end - data < 4)
+      return;
+    numNodes = qFromBigEndian<quint32>(data);
+    data += 4;
+
     geometry.holes.append(Boundary());
-    in >> numNodes;
+    Boundary& hole = geometry.holes.last();
+    hole.reserve(static_cast<int>(std::min(numNodes, static_cast<quint32>(end - data) / 9)));
     for(quint32 j = 0; j < numNodes; j++)
     {
       Node node;
-      readNode(in, node);
-      geometry.holes.last().append(node);
+      if(!readNode(data, end, node))
+        return;
+      hole.append(node);
     }
   }
 }
@@ -112,21 +142,24 @@ void XpGeometry::writeNode(QDataStream& out, const atools::fs::common::Node& nod
     out << NODE_TYPE_LINE << node.node.getLonX() << node.node.getLatY();
 }
 
-void XpGeometry::readNode(QDataStream& in, atools::fs::common::Node& node)
+bool XpGeometry::readNode(const uchar *& data, const uchar *end, atools::fs::common::Node& node)
 {
-  qint8 type;
-  float lonx, laty;
+  if(end - data < 9)
+    return false;
 
-  in >> type;
-
-  in >> lonx >> laty;
-  node.node = Pos(lonx, laty);
+  qint8 type = static_cast<qint8>(data[0]);
+  node.node = Pos(readFloat(data + 1), readFloat(data + 5));
+  data += 9;
 
   if(type == NODE_TYPE_CURVE)
   {
-    in >> lonx >> laty;
-    node.control = Pos(lonx, laty);
+    if(end - data < 8)
+      return false;
+
+    node.control = Pos(readFloat(data), readFloat(data + 4));
+    data += 8;
   }
+  return true;
 }
 
 void XpGeometry::clear()
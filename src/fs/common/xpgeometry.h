@@ -54,6 +54,8 @@ public:
 
   void addHoleNode(const atools::geo::Pos& node, const atools::geo::Pos& control, bool newHole);
 
+  /* Decodes directly from the bytes written by writeToByteArray(). Truncated data is read up to the last
+   * complete node. */
   void readFromByteArray(const QByteArray& bytes);
   QByteArray writeToByteArray();
 
@@ -71,7 +73,8 @@ public:
 
 private:
   void writeNode(QDataStream& out, const Node& node);
-  void readNode(QDataStream& in, atools::fs::common::Node& node);
+  /* Read one node and advance data. Returns false if there is not enough data left. */
+  static bool readNode(const uchar *& data, const uchar *end, atools::fs::common::Node& node);
 
   static constexpr qint8 NODE_TYPE_LINE = 0x01;
   static constexpr qint8 NODE_TYPE_CURVE = 0x02;
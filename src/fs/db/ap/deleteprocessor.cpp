@@ -231,7 +231,7 @@ void DeleteProcessor::preProcessDelete()
   extractPreviousAirportFeatures();
 
   // Delete the whole tree of approaches, transitions and legs on the old airport later in
-  // ":/atools/resources/sql/fs/db/delete_duplicates.sql"
+  // NavDatabase::removeDuplicates()
 
   // if(prevHasApproach && isFlagSet(deleteFlags, bgl::del::APPROACHES))
   // {
@@ -25,14 +25,22 @@ namespace db {
 
 void DbAirportIndex::add(const QString& airportIdent, int airportId)
 {
-  airportIndexMap[airportIdent] = airportId;
+  if(atools::fs::common::IndexName::fits(airportIdent))
+    airportIndexMap.insert(atools::fs::common::IndexName(airportIdent), airportId);
+  else
+  {
+    qWarning() << Q_FUNC_INFO << "Airport ident does not fit into index" << airportIdent;
+    airportIndexFallback.insert(airportIdent, airportId);
+  }
 }
 
 int DbAirportIndex::getAirportId(const QString& airportIdent, const QString& sourceObject)
 {
-  AirportIndexTypeConstIter it = airportIndexMap.find(airportIdent);
-  if(it != airportIndexMap.end())
-    return it.value();
+  int id = atools::fs::common::IndexName::fits(airportIdent) ?
+           airportIndexMap.value(atools::fs::common::IndexName(airportIdent), -1) :
+           airportIndexFallback.value(airportIdent, -1);
+  if(id != -1)
+    return id;
   else
   {
     qWarning().nospace().noquote() << "Airport ID for ident " << airportIdent << " not found for " <<
@@ -18,7 +18,7 @@
 #ifndef ATOOLS_FS_DB_AIRPORTINDEX_H
 #define ATOOLS_FS_DB_AIRPORTINDEX_H
 
-#include <QHash>
+#include "fs/common/airportindex.h"
 
 namespace atools {
 namespace fs {
@@ -55,13 +55,15 @@ public:
   void clear()
   {
     airportIndexMap.clear();
+    airportIndexFallback.clear();
   }
 
 private:
-  typedef QHash<QString, int> AirportIndexType;
-  typedef atools::fs::db::DbAirportIndex::AirportIndexType::const_iterator AirportIndexTypeConstIter;
+  /* Packed ident as key avoids string hashing and comparison */
+  atools::fs::common::IndexHash<atools::fs::common::IndexName> airportIndexMap;
 
-  atools::fs::db::DbAirportIndex::AirportIndexType airportIndexMap;
+  /* Idents which do not fit into IndexName */
+  QHash<QString, int> airportIndexFallback;
 };
 
 } // namespace writer
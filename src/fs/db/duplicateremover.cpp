@@ -0,0 +1,250 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/db/duplicateremover.h"
+
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+
+#include <algorithm>
+#include <cmath>
+
+namespace atools {
+namespace fs {
+namespace db {
+
+using atools::sql::SqlDatabase;
+using atools::sql::SqlQuery;
+
+/* Temporary table for ids to delete */
+static const QString ID_TABLE("tmp_duplicate_ids");
+
+/* Separates key values in hash keys */
+static const QChar KEY_SEPARATOR(0x1f);
+
+/* Combine key group index and grid cell. Cell numbers are less than 65536 for cell sizes down to 0.01 deg. */
+inline static quint64 cellKey(int group, int cellX, int cellY)
+{
+  return (static_cast<quint64>(group) << 32) | (static_cast<quint64>(cellX & 0xffff) << 16) |
+         static_cast<quint64>(cellY & 0xffff);
+}
+
+DuplicateRemover::DuplicateRemover(SqlDatabase *sqlDb)
+  : db(sqlDb)
+{
+
+}
+
+int DuplicateRemover::removeAll()
+{
+  int num = removeDuplicateAirports();
+
+  // NDB and VOR ==================================
+  num += removeDuplicates("ndb", "ndb_id", {"ident", "frequency", "region"}, 0.1);
+  num += removeDuplicates("vor", "vor_id",
+                          {"ident", "frequency", "type", "region", "dme_only", "dme_altitude is null"}, 0.1);
+
+  // Marker ==================================
+  num += removeDuplicates("marker", "marker_id", {"heading", "type"}, 0.01);
+
+  // ILS same name and same type and then same name and close by ==================================
+  num += removeDuplicates("ils", "ils_id", {"ident", "name"}, 0.1);
+  num += removeDuplicates("ils", "ils_id", {"ident"}, 0.01);
+
+  // Close together having same name, region and type - 0.1 deg manhattan distance about 6 nm at the equator
+  num += removeDuplicates("waypoint", "waypoint_id", {"ident", "region", "type"}, 0.1);
+
+  return num;
+}
+
+int DuplicateRemover::removeDuplicateAirports()
+{
+  // Find highest id for each ident - null idents form one group like in SQL "group by"
+  QHash<QString, int> maxIds;
+  int maxNullId = -1;
+  QVector<std::pair<int, QString> > airports;
+  QVector<int> nullIds;
+
+  SqlQuery query(db);
+  query.exec("select airport_id, ident from airport");
+  while(query.next())
+  {
+    int id = query.valueInt(0);
+    if(query.isNull(1))
+    {
+      nullIds.append(id);
+      maxNullId = std::max(maxNullId, id);
+    }
+    else
+    {
+      QString ident = query.valueStr(1);
+      airports.append(std::make_pair(id, ident));
+      int& maxId = maxIds[ident];
+      maxId = std::max(maxId, id);
+    }
+  }
+
+  QVector<int> ids;
+  for(const std::pair<int, QString>& airport : airports)
+  {
+    if(airport.first != maxIds.value(airport.second))
+      ids.append(airport.first);
+  }
+
+  for(int id : nullIds)
+  {
+    if(id != maxNullId)
+      ids.append(id);
+  }
+
+  if(!ids.isEmpty())
+  {
+    // Print duplicate airports to the log
+    SqlQuery log(db);
+    log.prepare("select airport_id, ident, name, scenery_local_path, bgl_filename from airport "
+                "where airport_id = ?");
+    for(int id : ids)
+    {
+      log.bindValue(0, id);
+      log.exec();
+      if(log.next())
+        qInfo() << "Duplicate airport" << log.valueInt(0) << log.valueStr(1) << log.valueStr(2)
+                << log.valueStr(3) << log.valueStr(4);
+    }
+  }
+
+  deleteIds("airport", "airport_id", ids);
+  return ids.size();
+}
+
+int DuplicateRemover::removeDuplicates(const QString& table, const QString& idColumn, const QStringList& keyColumns,
+                                       double maxDistanceDeg)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  struct Row
+  {
+    int id, group;
+    double lonx, laty;
+  };
+
+  QVector<Row> rows;
+  QHash<QString, int> groups;
+  QHash<quint64, QVector<int> > grid;
+
+  // Read all rows and sort them into key groups and grid cells ======================
+  SqlQuery query(db);
+  query.exec("select " + idColumn + ", lonx, laty, " + keyColumns.join(", ") + " from " + table);
+  while(query.next())
+  {
+    QString key;
+    bool hasNull = false;
+    for(int i = 0; i < keyColumns.size() && !hasNull; i++)
+    {
+      QVariant value = query.value(i + 3);
+      if(value.isNull())
+        // SQL null is never equal to anything
+        hasNull = true;
+      else
+        key.append(value.toString()).append(KEY_SEPARATOR);
+    }
+
+    if(hasNull)
+      continue;
+
+    int group = groups.value(key, -1);
+    if(group == -1)
+    {
+      group = groups.size();
+      groups.insert(key, group);
+    }
+
+    Row row = {query.valueInt(0), group, query.valueDouble(1), query.valueDouble(2)};
+    grid[cellKey(group, static_cast<int>(std::floor(row.lonx / maxDistanceDeg)),
+                 static_cast<int>(std::floor(row.laty / maxDistanceDeg)))].append(rows.size());
+    rows.append(row);
+  }
+
+  // Find rows having a duplicate with a higher id in the same or neighboring cells ======================
+  QVector<int> ids;
+  for(const Row& row : rows)
+  {
+    int cellX = static_cast<int>(std::floor(row.lonx / maxDistanceDeg));
+    int cellY = static_cast<int>(std::floor(row.laty / maxDistanceDeg));
+    bool duplicate = false;
+
+    for(int x = cellX - 1; x <= cellX + 1 && !duplicate; x++)
+    {
+      for(int y = cellY - 1; y <= cellY + 1 && !duplicate; y++)
+      {
+        auto it = grid.constFind(cellKey(row.group, x, y));
+        if(it == grid.constEnd())
+          continue;
+
+        for(int index : it.value())
+        {
+          const Row& other = rows.at(index);
+          if(other.id > row.id &&
+             (std::abs(row.lonx - other.lonx) + std::abs(row.laty - other.laty)) < maxDistanceDeg)
+          {
+            duplicate = true;
+            break;
+          }
+        }
+      }
+    }
+
+    if(duplicate)
+      ids.append(row.id);
+  }
+
+  deleteIds(table, idColumn, ids);
+
+  qDebug() << Q_FUNC_INFO << table << keyColumns << "rows" << rows.size() << "deleted" << ids.size()
+           << timer.elapsed() << "ms";
+
+  return ids.size();
+}
+
+void DuplicateRemover::deleteIds(const QString& table, const QString& idColumn, const QVector<int>& ids)
+{
+  if(ids.isEmpty())
+    return;
+
+  db->exec("drop table if exists " + ID_TABLE);
+  db->exec("create table " + ID_TABLE + " (id integer primary key)");
+
+  SqlQuery insert(db);
+  insert.prepare("insert or ignore into " + ID_TABLE + " (id) values(?)");
+  for(int id : ids)
+  {
+    insert.bindValue(0, id);
+    insert.exec();
+  }
+
+  db->exec("delete from " + table + " where " + idColumn + " in (select id from " + ID_TABLE + ")");
+  db->exec("drop table if exists " + ID_TABLE);
+}
+
+} // namespace db
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,74 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_DB_DUPLICATEREMOVER_H
+#define ATOOLS_FS_DB_DUPLICATEREMOVER_H
+
+#include <QStringList>
+#include <QVector>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace db {
+
+/*
+ * Removes duplicates resulting from add-on BGL files or other sources which are not covered by the delete
+ * processor. Only the duplicate with the highest id is kept. This means stock/default/oldest are removed and
+ * add-on are kept.
+ *
+ * Each table is read once and duplicates are detected using hash keys and a coarse spatial grid. All
+ * duplicates are then removed with one bulk delete by id. Replaces the self joins previously done in
+ * delete_duplicates.sql which only keeps the cascaded deletes for dependent tables.
+ */
+class DuplicateRemover
+{
+public:
+  DuplicateRemover(atools::sql::SqlDatabase *sqlDb);
+
+  /* Remove duplicates from airport, ndb, vor, marker, ils and waypoint tables.
+   * @return total number of deleted rows */
+  int removeAll();
+
+  /* Delete all airports with the same ident except the one with the highest id. Deleted airports are logged. */
+  int removeDuplicateAirports();
+
+  /*
+   * Delete all rows having equal key values where another row with a higher id is closer than
+   * maxDistanceDeg using the manhattan distance in degrees. Rows with null values in keys are never
+   * duplicates.
+   * @param keyColumns Column names or expressions which have to be equal
+   * @return number of deleted rows
+   */
+  int removeDuplicates(const QString& table, const QString& idColumn, const QStringList& keyColumns,
+                       double maxDistanceDeg);
+
+private:
+  /* Delete all rows by id using a temporary table */
+  void deleteIds(const QString& table, const QString& idColumn, const QVector<int>& ids);
+
+  atools::sql::SqlDatabase *db;
+};
+
+} // namespace db
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_DB_DUPLICATEREMOVER_H
@@ -0,0 +1,140 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/db/mapoverviewwriter.h"
+
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QVector>
+
+#include <algorithm>
+
+namespace atools {
+namespace fs {
+namespace db {
+
+using atools::sql::SqlDatabase;
+using atools::sql::SqlQuery;
+
+/* Importance for airports. Closed airports come last. Rating is calculated by
+ * atools::fs::util::calculateAirportRating() when writing the airport. */
+static const QString AIRPORT_QUERY(
+  "select airport_id as id, lonx, laty, "
+  "  (1 - is_closed) * 10000000 + rating * 1000000 + (num_runway_hard > 0) * 100000 + "
+  "  min(coalesce(longest_runway_length, 0), 99999) as importance "
+  "from airport order by importance desc, airport_id");
+
+/* High power VOR and VORTAC first. DME only stations are ranked one class lower. */
+static const QString VOR_QUERY(
+  "select vor_id as id, lonx, laty, "
+  "  ((case when type in ('H', 'VTH') then 3 when type in ('L', 'VTL', 'TC') then 2 else 1 end) - dme_only) * 10000 + "
+  "  range as importance "
+  "from vor order by importance desc, vor_id");
+
+static const QString NDB_QUERY(
+  "select ndb_id as id, lonx, laty, "
+  "  (case type when 'HH' then 3 when 'H' then 2 when 'MH' then 1 else 0 end) * 10000 + "
+  "  coalesce(range, 0) as importance "
+  "from ndb order by importance desc, ndb_id");
+
+/* Waypoints by number of airways and named before unnamed ones */
+static const QString WAYPOINT_QUERY(
+  "select waypoint_id as id, lonx, laty, "
+  "  (num_victor_airway + num_jet_airway) * 10 + (case when type = 'WN' then 1 else 0 end) as importance "
+  "from waypoint order by importance desc, waypoint_id");
+
+MapOverviewWriter::MapOverviewWriter(SqlDatabase *sqlDb)
+  : db(sqlDb)
+{
+
+}
+
+int MapOverviewWriter::write()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  db->exec("delete from map_overview");
+
+  SqlQuery insertQuery(db);
+  insertQuery.prepare("insert into map_overview "
+                      "(type, nav_id, zoom, tile_x, tile_y, tile_rank, importance, lonx, laty) "
+                      "values(:type, :navId, :zoom, :tileX, :tileY, :tileRank, :importance, :lonx, :laty)");
+
+  int num = writeType(insertQuery, "A", AIRPORT_QUERY);
+  num += writeType(insertQuery, "V", VOR_QUERY);
+  num += writeType(insertQuery, "N", NDB_QUERY);
+  num += writeType(insertQuery, "W", WAYPOINT_QUERY);
+  db->commit();
+
+  qDebug() << Q_FUNC_INFO << "rows" << num << timer.elapsed() << "ms";
+  return num;
+}
+
+int MapOverviewWriter::writeType(SqlQuery& insertQuery, const QString& type, const QString& queryStr)
+{
+  // Number of objects already added for each zoom level and tile
+  QVector<QVector<int> > tileCounts;
+  for(int zoom = 0; zoom <= maxZoom; zoom++)
+    tileCounts.append(QVector<int>((1 << zoom) * (1 << zoom), 0));
+
+  int num = 0;
+  insertQuery.bindValue(":type", type);
+
+  // Objects are sorted by descending importance - first ones in a tile are the most important
+  SqlQuery query(queryStr, db);
+  query.exec();
+  while(query.next())
+  {
+    float lonx = query.valueFloat("lonx"), laty = query.valueFloat("laty");
+    float x = std::max(0.f, std::min((lonx + 180.f) / 360.f, 1.f));
+    float y = std::max(0.f, std::min((90.f - laty) / 180.f, 1.f));
+
+    for(int zoom = 0; zoom <= maxZoom; zoom++)
+    {
+      int numTiles = 1 << zoom;
+      int tileX = std::min(static_cast<int>(x * numTiles), numTiles - 1);
+      int tileY = std::min(static_cast<int>(y * numTiles), numTiles - 1);
+
+      int& count = tileCounts[zoom][tileY * numTiles + tileX];
+      if(count >= objectsPerTile)
+        // Tile full - continue with next level which has smaller tiles
+        continue;
+
+      insertQuery.bindValue(":navId", query.valueInt("id"));
+      insertQuery.bindValue(":zoom", zoom);
+      insertQuery.bindValue(":tileX", tileX);
+      insertQuery.bindValue(":tileY", tileY);
+      insertQuery.bindValue(":tileRank", count);
+      insertQuery.bindValue(":importance", query.valueInt("importance"));
+      insertQuery.bindValue(":lonx", lonx);
+      insertQuery.bindValue(":laty", laty);
+      insertQuery.exec();
+
+      count++;
+      num++;
+    }
+  }
+  return num;
+}
+
+} // namespace db
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,76 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_DB_MAPOVERVIEWWRITER_H
+#define ATOOLS_FS_DB_MAPOVERVIEWWRITER_H
+
+#include <QString>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+class SqlQuery;
+}
+
+namespace fs {
+namespace db {
+
+/*
+ * Fills the table map_overview with the most important airports, VOR, NDB and waypoints for each zoom level
+ * and tile. This allows a client to load a bounded number of objects for any viewport at any zoom level
+ * instead of fetching all objects and thinning them out.
+ *
+ * Objects are ranked by an importance value which is calculated from the airport rating, the longest
+ * runway and hard surface for airports, from type and range for navaids and from the number of
+ * airways for waypoints. Each tile gets the most important objects which means that objects of a
+ * lower zoom level are also present in all higher zoom levels.
+ *
+ * Needs to run after all ids are final, i.e. after SpatialClusterer.
+ */
+class MapOverviewWriter
+{
+public:
+  MapOverviewWriter(atools::sql::SqlDatabase *sqlDb);
+
+  /* Clear and fill table map_overview. Returns number of rows written. */
+  int write();
+
+  /* Highest zoom level. Zoom level z has 2^z by 2^z tiles. Default is 8. */
+  void setMaxZoom(int value)
+  {
+    maxZoom = value;
+  }
+
+  /* Maximum number of objects of one type in each tile. Default is 16. */
+  void setObjectsPerTile(int value)
+  {
+    objectsPerTile = value;
+  }
+
+private:
+  /* Select objects from query and insert ranked objects into all tiles */
+  int writeType(atools::sql::SqlQuery& insertQuery, const QString& type, const QString& queryStr);
+
+  atools::sql::SqlDatabase *db;
+  int maxZoom = 8, objectsPerTile = 16;
+};
+
+} // namespace db
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_DB_MAPOVERVIEWWRITER_H
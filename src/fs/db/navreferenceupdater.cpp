@@ -0,0 +1,248 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/db/navreferenceupdater.h"
+
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlutil.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+#include <cmath>
+
+namespace atools {
+namespace fs {
+namespace db {
+
+using atools::sql::SqlDatabase;
+using atools::sql::SqlQuery;
+using atools::sql::SqlUtil;
+
+/* Maximum manhattan distance in degree between waypoint and navaid */
+static const double MAX_NAVAID_DISTANCE_DEG = 0.01;
+
+/* Separates ident and region in hash keys */
+static const QChar KEY_SEPARATOR(0x1f);
+
+NavReferenceUpdater::NavReferenceUpdater(SqlDatabase *sqlDb)
+  : db(sqlDb)
+{
+
+}
+
+void NavReferenceUpdater::updateWaypointNavIds()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  int num = updateWaypointNavIds("V", "vor", "vor_id");
+  num += updateWaypointNavIds("N", "ndb", "ndb_id");
+
+  qDebug() << Q_FUNC_INFO << "updated" << num << timer.elapsed() << "ms";
+}
+
+int NavReferenceUpdater::updateWaypointNavIds(const QString& type, const QString& navTable,
+                                              const QString& navIdColumn)
+{
+  struct Navaid
+  {
+    int id;
+    double lonx, laty;
+  };
+
+  // Read navaids into hash table by ident and region ===========================
+  // Null values never match
+  QHash<QString, QVector<Navaid> > navaids;
+  SqlQuery query(db);
+  query.exec("select " + navIdColumn + ", ident, region, lonx, laty from " + navTable +
+             " where ident is not null and region is not null order by " + navIdColumn);
+  while(query.next())
+    navaids[query.valueStr(1) + KEY_SEPARATOR + query.valueStr(2)].
+    append({query.valueInt(0), query.valueDouble(3), query.valueDouble(4)});
+
+  // Find navaid for each waypoint and collect changed ones ===========================
+  QVector<std::pair<int, int> > changed;
+  query.prepare("select waypoint_id, ident, region, lonx, laty, nav_id from waypoint where type = ?");
+  query.bindValue(0, type);
+  query.exec();
+  while(query.next())
+  {
+    int navId = -1;
+    if(!query.isNull(1) && !query.isNull(2))
+    {
+      auto it = navaids.constFind(query.valueStr(1) + KEY_SEPARATOR + query.valueStr(2));
+      if(it != navaids.constEnd())
+      {
+        double lonx = query.valueDouble(3), laty = query.valueDouble(4);
+
+        // Sorted by id - use first like the former subquery
+        for(const Navaid& navaid : it.value())
+        {
+          if(std::abs(navaid.lonx - lonx) + std::abs(navaid.laty - laty) < MAX_NAVAID_DISTANCE_DEG)
+          {
+            navId = navaid.id;
+            break;
+          }
+        }
+      }
+    }
+
+    bool oldNull = query.isNull(5);
+    if(oldNull != (navId == -1) || (!oldNull && query.valueInt(5) != navId))
+      changed.append(std::make_pair(query.valueInt(0), navId));
+  }
+  query.finish();
+
+  // Write after reading to avoid modifying the table while iterating
+  SqlQuery update(db);
+  update.prepare("update waypoint set nav_id = ? where waypoint_id = ?");
+  for(const std::pair<int, int>& change : changed)
+  {
+    update.bindValue(0, change.second == -1 ? QVariant(QVariant::Int) : QVariant(change.second));
+    update.bindValue(1, change.first);
+    update.exec();
+  }
+  return changed.size();
+}
+
+void NavReferenceUpdater::updateWaypointAirwayCounts()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  // Count adjacent airways for each waypoint id ===========================
+  SqlQuery query(db);
+  query.exec("select max(waypoint_id) from waypoint");
+  int maxId = query.next() ? query.valueInt(0) : 0;
+  QVector<int> numVictor(maxId + 1, 0), numJet(maxId + 1, 0);
+
+  query.exec("select from_waypoint_id, to_waypoint_id, airway_type from airway");
+  while(query.next())
+  {
+    QString airwayType = query.valueStr(2);
+    bool victor = airwayType == "V" || airwayType == "B", jet = airwayType == "J" || airwayType == "B";
+    if(!victor && !jet)
+      continue;
+
+    int fromId = query.isNull(0) ? -1 : query.valueInt(0), toId = query.isNull(1) ? -1 : query.valueInt(1);
+
+    // Count the airway only once if it starts and ends at the same waypoint
+    for(int id : {fromId, toId != fromId ? toId : -1})
+    {
+      if(id >= 0 && id <= maxId)
+      {
+        if(victor)
+          numVictor[id]++;
+        if(jet)
+          numJet[id]++;
+      }
+    }
+  }
+
+  // Collect changed counts ===========================
+  QVector<int> changed;
+  query.exec("select waypoint_id, num_victor_airway, num_jet_airway from waypoint");
+  while(query.next())
+  {
+    int id = query.valueInt(0);
+    int victor = id >= 0 && id <= maxId ? numVictor.at(id) : 0, jet = id >= 0 && id <= maxId ? numJet.at(id) : 0;
+
+    if(query.isNull(1) || query.isNull(2) || query.valueInt(1) != victor || query.valueInt(2) != jet)
+      changed.append(id);
+  }
+  query.finish();
+
+  SqlQuery update(db);
+  update.prepare("update waypoint set num_victor_airway = ?, num_jet_airway = ? where waypoint_id = ?");
+  for(int id : changed)
+  {
+    bool valid = id >= 0 && id <= maxId;
+    update.bindValue(0, valid ? numVictor.at(id) : 0);
+    update.bindValue(1, valid ? numJet.at(id) : 0);
+    update.bindValue(2, id);
+    update.exec();
+  }
+
+  qDebug() << Q_FUNC_INFO << "updated" << changed.size() << timer.elapsed() << "ms";
+}
+
+void NavReferenceUpdater::updateAirportRegions()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  int num = updateAirportRegions("waypoint");
+  num += updateAirportRegions("vor");
+  num += updateAirportRegions("ndb");
+
+  qDebug() << Q_FUNC_INFO << "updated" << num << timer.elapsed() << "ms";
+}
+
+int NavReferenceUpdater::updateAirportRegions(const QString& table)
+{
+  if(!SqlUtil(db).hasTable(table))
+    return 0;
+
+  // Airports still missing a region
+  QHash<int, QString> regions;
+  SqlQuery query(db);
+  query.exec("select airport_id from airport where region is null");
+  while(query.next())
+    regions.insert(query.valueInt(0), QString());
+
+  if(regions.isEmpty())
+    return 0;
+
+  // Use region of the first row for each airport like the former subquery - region can be null
+  QSet<int> found;
+  query.exec("select airport_id, region from " + table + " where airport_id is not null order by rowid");
+  while(query.next())
+  {
+    int airportId = query.valueInt(0);
+    if(regions.contains(airportId) && !found.contains(airportId))
+    {
+      found.insert(airportId);
+      if(!query.isNull(1))
+        regions[airportId] = query.valueStr(1);
+    }
+  }
+
+  SqlQuery update(db);
+  update.prepare("update airport set region = ? where airport_id = ?");
+
+  int num = 0;
+  for(auto it = regions.constBegin(); it != regions.constEnd(); ++it)
+  {
+    if(!it.value().isNull())
+    {
+      update.bindValue(0, it.value());
+      update.bindValue(1, it.key());
+      update.exec();
+      num++;
+    }
+  }
+  return num;
+}
+
+} // namespace db
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,66 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_DB_NAVREFERENCEUPDATER_H
+#define ATOOLS_FS_DB_NAVREFERENCEUPDATER_H
+
+#include <QString>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace db {
+
+/*
+ * Updates derived columns in the waypoint and airport tables after loading.
+ *
+ * Tables are read once into hash tables and count arrays instead of using correlated subqueries for each row.
+ * Only changed values are written back. Replaces the scripts update_wp_ids.sql and update_airport.sql.
+ */
+class NavReferenceUpdater
+{
+public:
+  NavReferenceUpdater(atools::sql::SqlDatabase *sqlDb);
+
+  /* Set waypoint.nav_id for VOR and NDB waypoints to the id of the navaid with the same ident and
+   * region close by. Set to null if no navaid is found. */
+  void updateWaypointNavIds();
+
+  /* Update waypoint.num_victor_airway and waypoint.num_jet_airway from table airway */
+  void updateWaypointAirwayCounts();
+
+  /* Fill null airport.region from waypoints, VORs or NDBs belonging to the airport */
+  void updateAirportRegions();
+
+private:
+  /* Update waypoint nav_id for given type using the navaid table */
+  int updateWaypointNavIds(const QString& type, const QString& navTable, const QString& navIdColumn);
+
+  /* Fill null regions from the first row of table belonging to the airport */
+  int updateAirportRegions(const QString& table);
+
+  atools::sql::SqlDatabase *db;
+};
+
+} // namespace db
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_DB_NAVREFERENCEUPDATER_H
@@ -25,11 +25,15 @@ namespace db {
 
 static QLatin1Literal NO_RWY("00");
 
-using std::make_pair;
-
 void RunwayIndex::add(const QString& airportIdent, const QString& runwayName, int runwayEndId)
 {
-  runwayIndexMap[RunwayIndexKeyType(airportIdent, runwayName)] = runwayEndId;
+  if(atools::fs::common::IndexName2::fits(airportIdent, runwayName))
+    runwayIndexMap.insert(atools::fs::common::IndexName2(airportIdent, runwayName), runwayEndId);
+  else
+  {
+    qWarning() << Q_FUNC_INFO << "Runway name does not fit into index" << airportIdent << runwayName;
+    runwayIndexFallback.insert(qMakePair(airportIdent, runwayName), runwayEndId);
+  }
 }
 
 int RunwayIndex::getRunwayEndId(const QString& airportIdent,
@@ -39,11 +43,11 @@ int RunwayIndex::getRunwayEndId(const QString& airportIdent,
   if(runwayName == NO_RWY)
     return -1;
 
-  RunwayIndexKeyType key(airportIdent, runwayName);
-
-  RunwayIndexTypeConstIter it = runwayIndexMap.find(key);
-  if(it != runwayIndexMap.end())
-    return it.value();
+  int id = atools::fs::common::IndexName2::fits(airportIdent, runwayName) ?
+           runwayIndexMap.value(atools::fs::common::IndexName2(airportIdent, runwayName), -1) :
+           runwayIndexFallback.value(qMakePair(airportIdent, runwayName), -1);
+  if(id != -1)
+    return id;
   else
   {
     qWarning().nospace().noquote() << "Runway end ID for airport " << airportIdent << " and runway " <<
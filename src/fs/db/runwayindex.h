@@ -18,7 +18,7 @@
 #ifndef ATOOLS_FS_DB_RUNWAYINDEX_H
 #define ATOOLS_FS_DB_RUNWAYINDEX_H
 
-#include <QHash>
+#include "fs/common/airportindex.h"
 
 namespace atools {
 namespace fs {
@@ -57,16 +57,15 @@ public:
   void clear()
   {
     runwayIndexMap.clear();
+    runwayIndexFallback.clear();
   }
 
 private:
-  /* key of airport ident and runway name. Use QPair since it has a hash function */
-  typedef QPair<QString, QString> RunwayIndexKeyType;
+  /* Key of packed airport ident and runway name */
+  atools::fs::common::IndexHash<atools::fs::common::IndexName2> runwayIndexMap;
 
-  typedef QHash<atools::fs::db::RunwayIndex::RunwayIndexKeyType, int> RunwayIndexType;
-  typedef atools::fs::db::RunwayIndex::RunwayIndexType::const_iterator RunwayIndexTypeConstIter;
-
-  atools::fs::db::RunwayIndex::RunwayIndexType runwayIndexMap;
+  /* Airport idents and runway names which do not fit into IndexName2. Use QPair since it has a hash function. */
+  QHash<QPair<QString, QString>, int> runwayIndexFallback;
 };
 
 } // namespace writer
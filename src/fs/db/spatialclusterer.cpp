@@ -0,0 +1,159 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/db/spatialclusterer.h"
+
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlrecord.h"
+#include "sql/sqlutil.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+namespace atools {
+namespace fs {
+namespace db {
+
+using atools::sql::SqlDatabase;
+using atools::sql::SqlQuery;
+using atools::sql::SqlUtil;
+
+/* Temporary table mapping old to new ids */
+static const QString ID_MAP_TABLE("tmp_cluster_id_map");
+
+/* Grid size for the Hilbert curve */
+static const quint32 HILBERT_SIZE = 65536;
+
+SpatialClusterer::SpatialClusterer(SqlDatabase *sqlDb)
+  : db(sqlDb)
+{
+
+}
+
+quint64 SpatialClusterer::hilbertKey(float lonx, float laty)
+{
+  quint32 x = static_cast<quint32>(std::max(0.f, std::min((lonx + 180.f) / 360.f, 1.f)) * (HILBERT_SIZE - 1));
+  quint32 y = static_cast<quint32>(std::max(0.f, std::min((laty + 90.f) / 180.f, 1.f)) * (HILBERT_SIZE - 1));
+
+  quint64 key = 0;
+  for(quint32 s = HILBERT_SIZE / 2; s > 0; s /= 2)
+  {
+    quint32 rx = (x & s) > 0, ry = (y & s) > 0;
+    key += static_cast<quint64>(s) * s * ((3 * rx) ^ ry);
+
+    // Rotate quadrant
+    if(ry == 0)
+    {
+      if(rx == 1)
+      {
+        x = HILBERT_SIZE - 1 - x;
+        y = HILBERT_SIZE - 1 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return key;
+}
+
+QStringList SpatialClusterer::findReferences(const QString& column, const QString& excludeTable) const
+{
+  QStringList references;
+  for(const QString& table : db->tables())
+  {
+    if(table != excludeTable && !table.startsWith("sqlite_") && db->record(table).contains(column))
+      references.append(table + "." + column);
+  }
+  return references;
+}
+
+int SpatialClusterer::cluster(const QString& table, const QString& idColumn, const QStringList& references)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  struct Row
+  {
+    quint64 key;
+    int id;
+  };
+
+  // Read ids and positions ===========================
+  QVector<Row> rows;
+  rows.reserve(SqlUtil(db).rowCount(table));
+  SqlQuery query(db);
+  query.exec("select " + idColumn + ", lonx, laty from " + table);
+  while(query.next())
+    rows.append({hilbertKey(query.valueFloat(1), query.valueFloat(2)), query.valueInt(0)});
+
+  if(rows.isEmpty())
+    return 0;
+
+  // Sort by curve and keep insert order for equal keys
+  std::sort(rows.begin(), rows.end(), [](const Row& r1, const Row& r2) -> bool
+        {
+          return r1.key == r2.key ? r1.id < r2.id : r1.key < r2.key;
+        });
+
+  // Write id map =================================
+  db->exec("drop table if exists " + ID_MAP_TABLE);
+  db->exec("create table " + ID_MAP_TABLE + " (old_id integer primary key, new_id integer not null)");
+
+  SqlQuery insert(db);
+  insert.prepare("insert into " + ID_MAP_TABLE + " (old_id, new_id) values(?, ?)");
+  for(int i = 0; i < rows.size(); i++)
+  {
+    insert.bindValue(0, rows.at(i).id);
+    insert.bindValue(1, i + 1);
+    insert.exec();
+  }
+
+  // Update primary key and all references ========================
+  updateReferences(table, idColumn);
+
+  SqlUtil util(db);
+  for(const QString& ref : references)
+  {
+    QString refTable = ref.section('.', 0, 0), refColumn = ref.section('.', 1, 1);
+    if(util.hasTable(refTable) && db->record(refTable).contains(refColumn))
+      updateReferences(refTable, refColumn);
+  }
+
+  db->exec("drop table if exists " + ID_MAP_TABLE);
+  db->commit();
+
+  qDebug() << Q_FUNC_INFO << table << "rows" << rows.size() << "references" << references
+           << timer.elapsed() << "ms";
+
+  return rows.size();
+}
+
+void SpatialClusterer::updateReferences(const QString& table, const QString& column)
+{
+  // Use negative values first to avoid unique constraint violations for primary keys
+  // Values not found in the map are left alone
+  db->exec("update " + table + " set " + column + " = -(select m.new_id from " + ID_MAP_TABLE + " m " +
+           "where m.old_id = " + table + "." + column + ") " +
+           "where " + column + " in (select old_id from " + ID_MAP_TABLE + ")");
+  db->exec("update " + table + " set " + column + " = -" + column + " where " + column + " < 0");
+}
+
+} // namespace db
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,73 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_DB_SPATIALCLUSTERER_H
+#define ATOOLS_FS_DB_SPATIALCLUSTERER_H
+
+#include <QStringList>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace db {
+
+/*
+ * Renumbers the primary keys of a table having lonx and laty columns in order of a Hilbert curve and
+ * updates all columns referencing this table.
+ *
+ * SQLite stores rows in the order of the integer primary key. Rows are inserted per BGL file or data source
+ * which means that a map viewport query reads pages scattered across the whole database file.
+ * Renumbering places neighboring objects on the same pages after the next vacuum.
+ *
+ * Needs to run after all references are resolved and before vacuum and analyze.
+ */
+class SpatialClusterer
+{
+public:
+  SpatialClusterer(atools::sql::SqlDatabase *sqlDb);
+
+  /*
+   * Renumber ids in table and update all referencing columns.
+   * @param table Table name having columns lonx and laty
+   * @param idColumn Integer primary key of table
+   * @param references List of referencing columns in the format "table.column". Missing tables
+   * or columns are ignored.
+   * @return number of renumbered rows
+   */
+  int cluster(const QString& table, const QString& idColumn, const QStringList& references);
+
+  /* Get all columns named column from all tables except the excluded in the format "table.column" */
+  QStringList findReferences(const QString& column, const QString& excludeTable) const;
+
+  /* Position on a Hilbert curve covering the whole world in a 65536 x 65536 grid */
+  static quint64 hilbertKey(float lonx, float laty);
+
+private:
+  /* Update all referencing column values using the id map table */
+  void updateReferences(const QString& table, const QString& column);
+
+  atools::sql::SqlDatabase *db;
+};
+
+} // namespace db
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_DB_SPATIALCLUSTERER_H
@@ -160,10 +160,13 @@ void DfdCompiler::writeAirports()
       airportWriteQuery->bindValue(":iata", QVariant::String);
     else
       airportWriteQuery->bindValue(":iata", iata);
-    airportWriteQuery->bindValue(":name", utl::capAirportName(airportQuery->valueStr("airport_name")));
+
+    // Check military and convert to caps in one pass
+    bool isMil, isClosed;
+    airportWriteQuery->bindValue(":name", utl::capAirportName(airportQuery->valueStr("airport_name"), isMil, isClosed));
     airportWriteQuery->bindValue(":country", airportQuery->valueStr("area_code"));
     airportWriteQuery->bindValue(":region", airportQuery->valueStr("icao_code"));
-    airportWriteQuery->bindValue(":is_military", utl::isNameMilitary(airportQuery->valueStr("airport_name")));
+    airportWriteQuery->bindValue(":is_military", isMil);
 
     // Will be extended later when reading runways
     airportWriteQuery->bindValue(":left_lonx", airportRect.getTopLeft().getLonX());
@@ -26,6 +26,11 @@
 #include "fs/scenery/addoncfg.h"
 #include "fs/db/airwayresolver.h"
 #include "fs/db/routeedgewriter.h"
+#include "fs/db/spatialclusterer.h"
+#include "fs/db/duplicateremover.h"
+#include "fs/db/navreferenceupdater.h"
+#include "fs/db/mapoverviewwriter.h"
+#include "fs/common/navsnapshot.h"
 #include "fs/progresshandler.h"
 #include "fs/scenery/fileresolver.h"
 #include "fs/scenery/addonpackage.h"
@@ -52,6 +57,9 @@ const int PROGRESS_NUM_RESOLVE_AIRWAY_STEPS = 1;
 const int PROGRESS_NUM_DEDUPLICATE_STEPS = 1;
 const int PROGRESS_NUM_ANALYZE_STEPS = 1;
 const int PROGRESS_NUM_VACCUM_STEPS = 1;
+const int PROGRESS_NUM_CLUSTER_STEPS = 2;
+const int PROGRESS_NUM_NAV_SNAPSHOT_STEPS = 1;
+const int PROGRESS_NUM_MAP_OVERVIEW_STEPS = 1;
 const int PROGRESS_NUM_DROP_INDEX_STEPS = 2;
 const int PROGRESS_DFD_EXTRA_STEPS = 13;
 
@@ -243,6 +251,9 @@ bool NavDatabase::isBasePathValid(const QString& filepath, QString& error, atool
 
 void NavDatabase::createInternal(const QString& sceneryConfigCodec)
 {
+  // Cache directory listings for file names with corrected case during the whole compilation
+  atools::PathNoCaseCacheScope cacheScope;
+
   int numProgressReports = 0, numSceneryAreas = 0, xplaneExtraSteps = 0;
   SceneryCfg cfg(sceneryConfigCodec);
 
@@ -304,6 +315,15 @@ void NavDatabase::createInternal(const QString& sceneryConfigCodec)
   if(options->isVacuumDatabase())
     total += PROGRESS_NUM_VACCUM_STEPS;
 
+  if(options->isClusterTables())
+    total += PROGRESS_NUM_CLUSTER_STEPS;
+
+  if(options->isWriteNavSnapshot())
+    total += PROGRESS_NUM_NAV_SNAPSHOT_STEPS;
+
+  if(options->isCreateMapOverview())
+    total += PROGRESS_NUM_MAP_OVERVIEW_STEPS;
+
   if(options->isDropIndexes())
     total += PROGRESS_NUM_DROP_INDEX_STEPS;
 
@@ -397,10 +417,16 @@ void NavDatabase::createInternal(const QString& sceneryConfigCodec)
       return;
   }
 
+  atools::fs::db::NavReferenceUpdater navReferenceUpdater(db);
+
   // Set the nav_ids (VOR, NDB) in the waypoint table and update the airway counts
-  if((aborted = runScript(&progress, "fs/db/update_wp_ids.sql", tr("Updating waypoints"))))
+  if((aborted = progress.reportOther(tr("Updating waypoints"))))
     return;
 
+  navReferenceUpdater.updateWaypointNavIds();
+  navReferenceUpdater.updateWaypointAirwayCounts();
+  db->commit();
+
   if(sim == atools::fs::FsPaths::NAVIGRAPH)
   {
     // Remove all unreferenced dummy waypoints that were added for airway generation
@@ -412,9 +438,12 @@ void NavDatabase::createInternal(const QString& sceneryConfigCodec)
   if((aborted = runScript(&progress, "fs/db/update_approaches.sql", tr("Updating approaches"))))
     return;
 
-  if((aborted = runScript(&progress, "fs/db/update_airport.sql", tr("Updating Airports"))))
+  if((aborted = progress.reportOther(tr("Updating Airports"))))
     return;
 
+  navReferenceUpdater.updateAirportRegions();
+  db->commit();
+
   if(sim != atools::fs::FsPaths::XPLANE11)
   {
     // The ids are already updated when reading the X-Plane data
@@ -505,6 +534,22 @@ void NavDatabase::createInternal(const QString& sceneryConfigCodec)
     createDatabaseReport(&progress);
   }
 
+  if(options->isClusterTables())
+  {
+    clusterTables(&progress);
+    if(aborted)
+      return;
+  }
+
+  if(options->isCreateMapOverview())
+  {
+    if((aborted = progress.reportOther(tr("Creating Map Overview"))))
+      return;
+
+    // Needs final ids after clustering
+    atools::fs::db::MapOverviewWriter(db).write();
+  }
+
   if(options->isDropIndexes())
   {
     if((aborted = progress.reportOther(tr("Creating Database preparation Script"))))
@@ -533,6 +578,16 @@ void NavDatabase::createInternal(const QString& sceneryConfigCodec)
     db->analyze();
   }
 
+  if(options->isWriteNavSnapshot())
+  {
+    if((aborted = progress.reportOther(tr("Writing Navaid Snapshot"))))
+      return;
+
+    // Needs final ids after clustering
+    atools::fs::common::NavSnapshot::write(db,
+                                           atools::fs::common::NavSnapshot::snapshotFilename(db->databaseName()));
+  }
+
   // Send the final progress report
   progress.reportFinish();
 
@@ -582,7 +637,7 @@ bool NavDatabase::loadDfd(ProgressHandler *progress, ng::DfdCompiler *dfdCompile
   if(options->isDeduplicate())
   {
     // Delete duplicates before any foreign keys ids are assigned
-    if((aborted = runScript(progress, "fs/db/delete_duplicates.sql", tr("Clean up"))))
+    if((aborted = removeDuplicates(progress)))
       return true;
   }
 
@@ -698,7 +753,7 @@ bool NavDatabase::loadXplane(ProgressHandler *progress, atools::fs::xp::XpDataCo
   if(options->isDeduplicate())
   {
     // Delete duplicates before any foreign keys ids are assigned
-    if((aborted = runScript(progress, "fs/db/delete_duplicates.sql", tr("Clean up"))))
+    if((aborted = removeDuplicates(progress)))
       return true;
   }
 
@@ -772,7 +827,7 @@ bool NavDatabase::loadFsxP3d(ProgressHandler *progress, atools::fs::db::DataWrit
   if(options->isDeduplicate())
   {
     // Delete duplicates before any foreign keys ids are assigned
-    if((aborted = runScript(progress, "fs/db/delete_duplicates.sql", tr("Clean up"))))
+    if((aborted = removeDuplicates(progress)))
       return true;
   }
 
@@ -839,6 +894,39 @@ void NavDatabase::createPreparationScript()
   db->commit();
 }
 
+bool NavDatabase::removeDuplicates(ProgressHandler *progress)
+{
+  if((aborted = progress->reportOther(tr("Clean up"))))
+    return true;
+
+  atools::fs::db::DuplicateRemover(db).removeAll();
+
+  // Remove orphaned procedures and duplicate airway points
+  SqlScript script(db, true /*options->isVerbose()*/);
+  script.executeScript(":/atools/resources/sql/fs/db/delete_duplicates.sql");
+  db->commit();
+  return false;
+}
+
+void NavDatabase::clusterTables(ProgressHandler *progress)
+{
+  atools::fs::db::SpatialClusterer clusterer(db);
+
+  if((aborted = progress->reportOther(tr("Sorting Airports by Position"))))
+    return;
+
+  // All tables having an airport_id column refer to the airport table
+  clusterer.cluster("airport", "airport_id", clusterer.findReferences("airport_id", "airport"));
+
+  if((aborted = progress->reportOther(tr("Sorting Waypoints by Position"))))
+    return;
+
+  // Route network only contains waypoints in table route_node_airway
+  QStringList waypointRefs = clusterer.findReferences("waypoint_id", "waypoint");
+  waypointRefs << "airway.from_waypoint_id" << "airway.to_waypoint_id" << "route_node_airway.nav_id";
+  clusterer.cluster("waypoint", "waypoint_id", waypointRefs);
+}
+
 void NavDatabase::dropAllIndexes()
 {
   QStringList stmts;
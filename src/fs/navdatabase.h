@@ -146,9 +146,18 @@ private:
   /* Run and report SQL script */
   bool runScript(atools::fs::ProgressHandler *progress, const QString& scriptFile, const QString& message);
 
+  /* Remove duplicate airports and navaids from add-ons and clean up dependent tables */
+  bool removeDuplicates(atools::fs::ProgressHandler *progress);
+
   void createPreparationScript();
   void dropAllIndexes();
 
+  /* Renumber airports and waypoints in spatial order so that map queries read fewer pages.
+   * VOR and NDB are not renumbered. Their ids are also referenced by columns like waypoint.nav_id,
+   * route_node_radio.nav_id or nav_search.waypoint_nav_id where the target table depends on a type column.
+   * SpatialClusterer cannot remap these and both tables are small enough to gain little from clustering. */
+  void clusterTables(atools::fs::ProgressHandler *progress);
+
   void readAddOnComponents(int& areaNum, atools::fs::scenery::SceneryCfg& cfg,
                            QVector<scenery::AddOnComponent>& noLayerComponents,
                            QStringList& noLayerPaths, QSet<QString>& addonPaths, const QFileInfo& addonEntry);
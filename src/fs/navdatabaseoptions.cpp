@@ -216,6 +216,9 @@ void NavDatabaseOptions::loadFromSettings(QSettings& settings)
   setFlag(type::VACUUM_DATABASE, settings.value("Options/VacuumDatabase", true).toBool());
   setFlag(type::ANALYZE_DATABASE, settings.value("Options/AnalyzeDatabase", true).toBool());
   setFlag(type::DROP_INDEXES, settings.value("Options/DropAllIndexes", false).toBool());
+  setFlag(type::CLUSTER_TABLES, settings.value("Options/ClusterTables", true).toBool());
+  setFlag(type::WRITE_NAV_SNAPSHOT, settings.value("Options/WriteNavSnapshot", false).toBool());
+  setFlag(type::CREATE_MAP_OVERVIEW, settings.value("Options/CreateMapOverview", true).toBool());
 
   addToHighPriorityFiltersInc(settings.value("Filter/IncludeHighPriorityFilter").toStringList());
 
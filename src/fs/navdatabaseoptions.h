@@ -136,7 +136,16 @@ enum OptionFlag
   ANALYZE_DATABASE = 1 << 13,
 
   /* Remove all indexes */
-  DROP_INDEXES = 1 << 14
+  DROP_INDEXES = 1 << 14,
+
+  /* Renumber airports and waypoints in spatial order before vacuum */
+  CLUSTER_TABLES = 1 << 15,
+
+  /* Write columnar snapshot file for map display next to the database */
+  WRITE_NAV_SNAPSHOT = 1 << 16,
+
+  /* Fill table map_overview with ranked objects per zoom level and tile */
+  CREATE_MAP_OVERVIEW = 1 << 17
 };
 
 Q_DECLARE_FLAGS(OptionFlags, OptionFlag);
@@ -355,6 +364,21 @@ public:
     return flags & type::DROP_INDEXES;
   }
 
+  bool isClusterTables() const
+  {
+    return flags & type::CLUSTER_TABLES;
+  }
+
+  bool isWriteNavSnapshot() const
+  {
+    return flags & type::WRITE_NAV_SNAPSHOT;
+  }
+
+  bool isCreateMapOverview() const
+  {
+    return flags & type::CREATE_MAP_OVERVIEW;
+  }
+
   bool isBasicValidation() const
   {
     return flags & type::BASIC_VALIDATION;
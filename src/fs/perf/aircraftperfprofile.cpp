@@ -0,0 +1,285 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/perf/aircraftperfprofile.h"
+
+#include "fs/perf/aircraftperf.h"
+#include "geo/calculations.h"
+
+#include <algorithm>
+
+namespace atools {
+namespace fs {
+namespace perf {
+
+/* Altitude tolerance in feet to detect level flight and restriction violations */
+static const float ALT_EPSILON_FT = 10.f;
+
+/* Maximum iterations for contingency fuel and weight */
+static const int MAX_WEIGHT_ITERATIONS = 8;
+
+/* Ground speed is not allowed to drop below this fraction of true airspeed in strong headwinds */
+static const float MIN_GROUND_SPEED_FACTOR = 0.1f;
+
+/* Clamp altitude to the restriction at the end of a leg. Maximum wins if both are in conflict. */
+static float clampRestriction(float altitude, const ProfileLeg& leg)
+{
+  return std::min(std::max(altitude, leg.minAltitudeFt), leg.maxAltitudeFt);
+}
+
+/* Limit head wind to keep ground speed positive */
+static float clampHeadWind(float headWind, float speed)
+{
+  return std::min(headWind, speed * (1.f - MIN_GROUND_SPEED_FACTOR));
+}
+
+AircraftPerfProfile::AircraftPerfProfile(const AircraftPerf& aircraftPerf)
+  : perf(aircraftPerf)
+{
+
+}
+
+void AircraftPerfProfile::calculate(ProfileResult& result, const QVector<ProfileLeg>& legs,
+                                    float departureAltFt, float destinationAltFt, float cruiseAltFt) const
+{
+  result = ProfileResult();
+  result.reserveFuel = perf.getReserveFuel();
+  result.extraFuel = perf.getExtraFuel();
+  result.taxiFuel = perf.getTaxiFuel();
+
+  if(!perf.isClimbValid() || !perf.isDescentValid() || !perf.isSpeedValid())
+    return;
+
+  int numLegs = legs.size();
+
+  // Forward pass for climb - altitude at each route point reachable by climbing from departure
+  QVector<float> climbAlt(numLegs + 1);
+  climbAlt[0] = departureAltFt;
+  for(int i = 0; i < numLegs; i++)
+  {
+    const ProfileLeg& leg = legs.at(i);
+    float climbRate = perf.getClimbRateFtPerNm(clampHeadWind(leg.headWindKts, perf.getClimbSpeed()));
+    float alt = climbAlt.at(i) + climbRate * leg.distanceNm;
+    climbAlt[i + 1] = clampRestriction(std::min(alt, cruiseAltFt), leg);
+  }
+
+  // Backward pass for descent - highest altitude at each point which still allows to reach destination
+  QVector<float> descentAlt(numLegs + 1);
+  descentAlt[numLegs] = destinationAltFt;
+  for(int i = numLegs - 1; i >= 0; i--)
+  {
+    const ProfileLeg& leg = legs.at(i);
+    float descentRate = perf.getDescentRateFtPerNm(clampHeadWind(leg.headWindKts, perf.getDescentSpeed()));
+    float alt = descentAlt.at(i + 1) + descentRate * leg.distanceNm;
+    alt = std::min(alt, cruiseAltFt);
+    if(i > 0)
+      // Restriction at end of previous leg
+      alt = clampRestriction(alt, legs.at(i - 1));
+    descentAlt[i] = alt;
+  }
+
+  calculateLegs(result, legs, climbAlt, descentAlt, cruiseAltFt);
+
+  if(zeroFuelWeight > 0.f && referenceWeight > 0.f)
+    calculateWeights(result);
+  else
+    result.contingencyFuel = result.tripFuel * (perf.getContingencyFuelFactor() - 1.f);
+
+  result.blockFuel = result.tripFuel + result.contingencyFuel + result.reserveFuel + result.extraFuel +
+                     result.taxiFuel;
+  result.valid = true;
+}
+
+void AircraftPerfProfile::calculateLegs(ProfileResult& result, const QVector<ProfileLeg>& legs,
+                                        const QVector<float>& climbAlt, const QVector<float>& descentAlt,
+                                        float cruiseAltFt) const
+{
+  result.legs.resize(legs.size());
+
+  float distanceFromStart = 0.f;
+  for(int i = 0; i < legs.size(); i++)
+  {
+    const ProfileLeg& leg = legs.at(i);
+    ProfileLegResult& legResult = result.legs[i];
+    float length = leg.distanceNm;
+
+    float climbRate = perf.getClimbRateFtPerNm(clampHeadWind(leg.headWindKts, perf.getClimbSpeed()));
+    float descentRate = perf.getDescentRateFtPerNm(clampHeadWind(leg.headWindKts, perf.getDescentSpeed()));
+
+    // Climb curve rises from start until it levels off at the top
+    float climbStart = climbAlt.at(i), climbTop = std::max(climbAlt.at(i + 1), climbStart);
+
+    // Descent curve is level at the top and descends to the end
+    float descentEnd = descentAlt.at(i + 1), descentTop = std::max(descentAlt.at(i), descentEnd);
+
+    // Climb or descend steeper if a minimum restriction raised the curves above the reachable altitude
+    bool steeper = false;
+    if(length > 0.f)
+    {
+      if(climbTop - climbStart > climbRate * length + ALT_EPSILON_FT)
+      {
+        climbRate = (climbTop - climbStart) / length;
+        steeper = true;
+      }
+      if(descentTop - descentEnd > descentRate * length + ALT_EPSILON_FT)
+      {
+        descentRate = (descentTop - descentEnd) / length;
+        steeper = true;
+      }
+    }
+
+    // Flown altitude is the lower of both curves
+    auto altitudeAt = [ = ](float x) -> float {
+                        float climb = std::min(climbTop, climbStart + climbRate * x);
+                        float descent = std::min(descentTop, descentEnd + descentRate * (length - x));
+                        return std::min(climb, descent);
+                      };
+
+    // Collect all points where the profile can change its slope ======================
+    float points[7];
+    int numPoints = 0;
+    points[numPoints++] = 0.f;
+    points[numPoints++] = length;
+    points[numPoints++] = (climbTop - climbStart) / climbRate; // Level off
+    points[numPoints++] = length - (descentTop - descentEnd) / descentRate; // Start descent
+    points[numPoints++] = (descentEnd + descentRate * length - climbStart) / (climbRate + descentRate); // Both slopes
+    points[numPoints++] = (descentTop - climbStart) / climbRate; // Climb meets level descent curve
+    points[numPoints++] = length - (climbTop - descentEnd) / descentRate; // Descent meets level climb curve
+
+    for(int j = 0; j < numPoints; j++)
+      points[j] = std::max(0.f, std::min(points[j], length));
+    std::sort(points, points + numPoints);
+
+    legResult.startAltitudeFt = altitudeAt(0.f);
+    legResult.endAltitudeFt = altitudeAt(length);
+
+    // Profile is linear between points - TOC is the first and TOD the last point at the highest altitude
+    for(int j = 0; j < numPoints; j++)
+    {
+      float alt = altitudeAt(points[j]);
+      if(result.tocLegIndex == -1 || alt > result.maxAltitudeFt + ALT_EPSILON_FT)
+      {
+        result.tocLegIndex = i;
+        result.tocDistanceNm = distanceFromStart + points[j];
+        result.maxAltitudeFt = alt;
+      }
+      else
+        result.maxAltitudeFt = std::max(result.maxAltitudeFt, alt);
+
+      if(alt >= result.maxAltitudeFt - ALT_EPSILON_FT)
+      {
+        result.todLegIndex = i;
+        result.todDistanceNm = distanceFromStart + points[j];
+      }
+    }
+
+    // Calculate time and fuel for each part ============================
+    for(int j = 0; j < numPoints - 1; j++)
+    {
+      float x1 = points[j], x2 = points[j + 1], partLength = x2 - x1;
+      if(!(partLength > 0.f))
+        continue;
+
+      float alt1 = altitudeAt(x1), alt2 = altitudeAt(x2);
+      float speed, fuelFlow;
+      if(alt2 > alt1 + ALT_EPSILON_FT)
+      {
+        legResult.climbDistanceNm += partLength;
+        speed = perf.getClimbSpeed();
+        fuelFlow = perf.getClimbFuelFlow();
+      }
+      else if(alt2 < alt1 - ALT_EPSILON_FT)
+      {
+        legResult.descentDistanceNm += partLength;
+        speed = perf.getDescentSpeed();
+        fuelFlow = perf.getDescentFuelFlow();
+      }
+      else
+      {
+        legResult.cruiseDistanceNm += partLength;
+        speed = perf.getCruiseSpeed();
+        fuelFlow = perf.getCruiseFuelFlow();
+      }
+
+      float time = partLength / (speed - clampHeadWind(leg.headWindKts, speed));
+      legResult.timeHours += time;
+      legResult.fuel += time * fuelFlow;
+    }
+
+    legResult.restrictionViolated = steeper || legResult.endAltitudeFt < leg.minAltitudeFt - ALT_EPSILON_FT ||
+                                    legResult.endAltitudeFt > leg.maxAltitudeFt + ALT_EPSILON_FT;
+
+    distanceFromStart += length;
+    result.tripTimeHours += legResult.timeHours;
+    result.tripFuel += legResult.fuel;
+  }
+  result.totalDistanceNm = distanceFromStart;
+  result.cruiseReached = result.tocLegIndex != -1 && result.maxAltitudeFt >= cruiseAltFt - ALT_EPSILON_FT;
+}
+
+void AircraftPerfProfile::calculateWeights(ProfileResult& result) const
+{
+  // Burn at reference weight
+  QVector<float> baseFuelLbs(result.legs.size());
+  for(int i = 0; i < result.legs.size(); i++)
+    baseFuelLbs[i] = toLbs(result.legs.at(i).fuel);
+
+  float contingencyFactor = perf.getContingencyFuelFactor() - 1.f;
+  float fixedFuelLbs = toLbs(result.reserveFuel + result.extraFuel);
+  float tripLbs = toLbs(result.tripFuel);
+
+  for(int iteration = 0; iteration < MAX_WEIGHT_ITERATIONS; iteration++)
+  {
+    // Contingency fuel is not burned and is carried until landing
+    result.landingWeightLbs = zeroFuelWeight + fixedFuelLbs + tripLbs * contingencyFactor;
+
+    float weight = result.landingWeightLbs, newTripLbs = 0.f;
+    for(int i = result.legs.size() - 1; i >= 0; i--)
+    {
+      // Fuel flow scales with the average weight on the leg which is end weight plus half of the burn:
+      // burn = base * (weight + burn / 2) / reference
+      float base = baseFuelLbs.at(i);
+      float burn = referenceWeight - base / 2.f > 0.f ? base * weight / (referenceWeight - base / 2.f) : base;
+      result.legs[i].fuel = fromLbs(burn);
+      weight += burn;
+      newTripLbs += burn;
+    }
+    result.takeoffWeightLbs = weight;
+
+    bool converged = std::abs(newTripLbs - tripLbs) < 0.001f * std::max(tripLbs, 1.f);
+    tripLbs = newTripLbs;
+    if(converged)
+      break;
+  }
+
+  result.tripFuel = fromLbs(tripLbs);
+  result.contingencyFuel = result.tripFuel * contingencyFactor;
+}
+
+float AircraftPerfProfile::toLbs(float fuel) const
+{
+  return perf.useFuelAsVolume() ? atools::geo::fromGalToLbs(perf.isJetFuel(), fuel) : fuel;
+}
+
+float AircraftPerfProfile::fromLbs(float fuelLbs) const
+{
+  return perf.useFuelAsVolume() ? atools::geo::fromLbsToGal(perf.isJetFuel(), fuelLbs) : fuelLbs;
+}
+
+} // namespace perf
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,153 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_AIRCRAFTPERFPROFILE_H
+#define ATOOLS_AIRCRAFTPERFPROFILE_H
+
+#include <QVector>
+#include <limits>
+
+namespace atools {
+namespace fs {
+namespace perf {
+
+class AircraftPerf;
+
+/* Input for one route leg */
+struct ProfileLeg
+{
+  float distanceNm = 0.f;
+
+  /* Head wind component for this leg in knots. Negative is tailwind. */
+  float headWindKts = 0.f;
+
+  /* Altitude restriction at the end of this leg in feet. Use the same value for "at" restrictions. */
+  float minAltitudeFt = 0.f, maxAltitudeFt = std::numeric_limits<float>::max();
+};
+
+/* Calculated values for one route leg. Fuel is in the unit of the performance file (lbs or gallons). */
+struct ProfileLegResult
+{
+  float startAltitudeFt = 0.f, endAltitudeFt = 0.f;
+
+  /* Distance flown in each phase. Level flight below cruise altitude is counted as cruise. */
+  float climbDistanceNm = 0.f, cruiseDistanceNm = 0.f, descentDistanceNm = 0.f;
+
+  float timeHours = 0.f, fuel = 0.f;
+
+  /* Altitude at end of leg could not meet the restriction or meeting it needs a steeper climb or descent
+   * than given by the performance data */
+  bool restrictionViolated = false;
+};
+
+/* Result of a profile calculation. Fuel is in the unit of the performance file (lbs or gallons). */
+struct ProfileResult
+{
+  QVector<atools::fs::perf::ProfileLegResult> legs;
+
+  /* Distance from departure to top of climb and top of descent. These are the first and last point at the
+   * highest altitude of the profile. Both are equal if the profile climbs and descends without level flight.
+   * -1 if there are no legs. */
+  float tocDistanceNm = -1.f, todDistanceNm = -1.f;
+
+  /* Leg index of TOC and TOD or -1 if there are no legs */
+  int tocLegIndex = -1, todLegIndex = -1;
+
+  /* Highest altitude of the profile */
+  float maxAltitudeFt = 0.f;
+
+  /* Highest altitude is at cruise altitude */
+  bool cruiseReached = false;
+
+  float totalDistanceNm = 0.f, tripTimeHours = 0.f;
+
+  /* tripFuel is fuel burned enroute. blockFuel is the sum of all fuel values. */
+  float tripFuel = 0.f, contingencyFuel = 0.f, reserveFuel = 0.f, extraFuel = 0.f, taxiFuel = 0.f, blockFuel = 0.f;
+
+  /* Only calculated if weights are set in AircraftPerfProfile */
+  float takeoffWeightLbs = 0.f, landingWeightLbs = 0.f;
+
+  /* false if performance data has invalid climb or descent values */
+  bool valid = false;
+
+  bool isValid() const
+  {
+    return valid;
+  }
+
+  bool isCruiseReached() const
+  {
+    return cruiseReached;
+  }
+
+};
+
+/*
+ * Calculates the vertical flight profile, time and fuel for a whole route in one pass based on AircraftPerf.
+ *
+ * Climb starts at departure and is calculated forward while descent is calculated backwards from destination.
+ * Both are clamped to the minimum and maximum altitude restrictions and use the per leg head wind.
+ * The flown altitude is the lower of both. A leg is climbed or descended steeper than given by the performance
+ * data if this is needed to meet a restriction. This is reported in ProfileLegResult::restrictionViolated.
+ *
+ * Fuel flow is constant by default. If weights are given, fuel flow scales linearly with gross weight and
+ * burn is calculated backwards from the landing weight. Contingency fuel is part of the carried weight
+ * and is iterated until trip fuel converges.
+ *
+ * The class does not keep state between calls and is re-entrant.
+ */
+class AircraftPerfProfile
+{
+public:
+  /* Performance object is not copied and has to be valid for the lifetime of this object */
+  AircraftPerfProfile(const atools::fs::perf::AircraftPerf& aircraftPerf);
+
+  /* Enable weight dependent fuel flow. Fuel flows in performance file are valid for reference weight.
+   * Set both to 0 to disable. */
+  void setWeights(float zeroFuelWeightLbs, float referenceWeightLbs)
+  {
+    zeroFuelWeight = zeroFuelWeightLbs;
+    referenceWeight = referenceWeightLbs;
+  }
+
+  /* Calculate profile for all legs. Altitudes in feet. */
+  void calculate(atools::fs::perf::ProfileResult& result, const QVector<atools::fs::perf::ProfileLeg>& legs,
+                 float departureAltFt, float destinationAltFt, float cruiseAltFt) const;
+
+private:
+  /* Split legs into phases and calculate time and fuel at reference weight */
+  void calculateLegs(atools::fs::perf::ProfileResult& result, const QVector<atools::fs::perf::ProfileLeg>& legs,
+                     const QVector<float>& climbAlt, const QVector<float>& descentAlt, float cruiseAltFt) const;
+
+  /* Scale leg fuel by weight backwards from destination */
+  void calculateWeights(atools::fs::perf::ProfileResult& result) const;
+
+  float toLbs(float fuel) const;
+  float fromLbs(float fuelLbs) const;
+
+  const atools::fs::perf::AircraftPerf& perf;
+  float zeroFuelWeight = 0.f, referenceWeight = 0.f;
+};
+
+} // namespace perf
+} // namespace fs
+} // namespace atools
+
+Q_DECLARE_TYPEINFO(atools::fs::perf::ProfileLeg, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(atools::fs::perf::ProfileLegResult, Q_PRIMITIVE_TYPE);
+
+#endif // ATOOLS_AIRCRAFTPERFPROFILE_H
@@ -21,6 +21,8 @@
 
 #include <QDebug>
 
+#include <limits>
+
 namespace atools {
 namespace fs {
 
@@ -28,20 +30,30 @@ ProgressHandler::ProgressHandler(const NavDatabaseOptions *options)
 {
   if(options->getProgressCallback() != nullptr)
     handler = options->getProgressCallback();
+
+  timer.start();
+  reset();
 }
 
 void ProgressHandler::increaseCurrent(int increase)
 {
-  info.current += increase;
+  current.fetch_add(increase, std::memory_order_relaxed);
 }
 
 bool ProgressHandler::reportUpdate()
 {
-  return callHandler();
+  if(!isReportDue() || !mutex.tryLock())
+    // Another thread is already reporting or too early
+    return isCanceled();
+
+  bool retval = callHandler();
+  mutex.unlock();
+  return retval;
 }
 
 bool ProgressHandler::reportOtherMsg(const QString& otherAction)
 {
+  QMutexLocker locker(&mutex);
   info.otherAction = otherAction;
   info.newFile = false;
   info.newSceneryArea = false;
@@ -50,12 +62,14 @@ bool ProgressHandler::reportOtherMsg(const QString& otherAction)
   return callHandler();
 }
 
-bool ProgressHandler::reportOther(const QString& otherAction, int current, bool silent)
+bool ProgressHandler::reportOther(const QString& otherAction, int currentParam, bool silent)
 {
-  if(current != -1)
-    info.current = current;
+  if(currentParam != -1)
+    current.store(currentParam, std::memory_order_relaxed);
   else
-    info.current++;
+    current.fetch_add(1, std::memory_order_relaxed);
+
+  QMutexLocker locker(&mutex);
   info.otherAction = otherAction;
 
   info.newFile = false;
@@ -63,54 +77,68 @@ bool ProgressHandler::reportOther(const QString& otherAction, int current, bool
   info.newOther = true;
 
   if(silent)
-    return false;
+    return isCanceled();
   else
     return callHandler();
 }
 
 void ProgressHandler::reportError()
 {
-  info.numErrors++;
+  numErrors.fetch_add(1, std::memory_order_relaxed);
 }
 
 void ProgressHandler::reportErrors(int num)
 {
-  info.numErrors += num;
+  numErrors.fetch_add(num, std::memory_order_relaxed);
 }
 
 bool ProgressHandler::reportBglFile(const QString& bglFilepath)
 {
-  info.current++;
+  current.fetch_add(1, std::memory_order_relaxed);
+
+  if(!isReportDue() || !mutex.tryLock())
+    // Coalesce - file is counted and shown with the next report
+    return isCanceled();
+
   info.bglFilepath = bglFilepath;
 
   info.newFile = true;
   info.newSceneryArea = false;
   info.newOther = false;
 
-  return callHandler();
+  bool retval = callHandler();
+  mutex.unlock();
+  return retval;
 }
 
 bool ProgressHandler::reportFinish()
 {
+  QMutexLocker locker(&mutex);
   info.lastCall = true;
   info.newFile = false;
   info.newSceneryArea = false;
   info.newOther = false;
 
-  qDebug() << Q_FUNC_INFO << "info.current" << info.current;
+  qDebug() << Q_FUNC_INFO << "current" << current.load();
 
   return callHandler();
 }
 
-void ProgressHandler::setTotal(int total)
+void ProgressHandler::setTotal(int totalParam)
 {
-  info.total = total;
+  total.store(totalParam, std::memory_order_relaxed);
 }
 
 void ProgressHandler::reset()
 {
-  info.numErrors = 0;
-  info.current = 0;
+  numErrors.store(0);
+  current.store(0);
+  canceled.store(false);
+
+  // Report first call immediately
+  lastReportMs.store(std::numeric_limits<qint64>::min() / 2);
+
+  QMutexLocker locker(&mutex);
   info.sceneryArea = nullptr;
   info.bglFilepath.clear();
   info.newFile = false;
@@ -120,12 +148,14 @@ void ProgressHandler::reset()
   info.lastCall = false;
 }
 
-bool ProgressHandler::reportSceneryArea(const scenery::SceneryArea *sceneryArea, int current)
+bool ProgressHandler::reportSceneryArea(const scenery::SceneryArea *sceneryArea, int currentParam)
 {
-  if(current != -1)
-    info.current = current;
+  if(currentParam != -1)
+    current.store(currentParam, std::memory_order_relaxed);
   else
-    info.current++;
+    current.fetch_add(1, std::memory_order_relaxed);
+
+  QMutexLocker locker(&mutex);
   info.sceneryArea = sceneryArea;
 
   info.newFile = false;
@@ -135,21 +165,41 @@ bool ProgressHandler::reportSceneryArea(const scenery::SceneryArea *sceneryArea,
   return callHandler();
 }
 
+bool ProgressHandler::isReportDue() const
+{
+  return timer.elapsed() - lastReportMs.load(std::memory_order_relaxed) >= reportIntervalMs;
+}
+
 bool ProgressHandler::callHandler()
 {
-  bool retval = false;
+  // Take a snapshot of all counters
+  info.numFiles = numFiles.load(std::memory_order_relaxed);
+  info.numAirports = numAirports.load(std::memory_order_relaxed);
+  info.numNamelists = numNamelists.load(std::memory_order_relaxed);
+  info.numVors = numVors.load(std::memory_order_relaxed);
+  info.numIls = numIls.load(std::memory_order_relaxed);
+  info.numNdbs = numNdbs.load(std::memory_order_relaxed);
+  info.numMarker = numMarker.load(std::memory_order_relaxed);
+  info.numBoundaries = numBoundaries.load(std::memory_order_relaxed);
+  info.numWaypoints = numWaypoints.load(std::memory_order_relaxed);
+  info.numObjectsWritten = numObjectsWritten.load(std::memory_order_relaxed);
+  info.numErrors = numErrors.load(std::memory_order_relaxed);
+  info.current = current.load(std::memory_order_relaxed);
+  info.total = total.load(std::memory_order_relaxed);
 
   // Alway call default handler - this one cannot call cancel
   defaultHandler(info);
 
-  if(handler != nullptr)
+  if(handler != nullptr && handler(info))
     // Call user handler
-    retval = handler(info);
+    cancel();
 
   if(info.firstCall)
     info.firstCall = false;
 
-  return retval;
+  lastReportMs.store(timer.elapsed(), std::memory_order_relaxed);
+
+  return isCanceled();
 }
 
 /*
@@ -177,7 +227,8 @@ void ProgressHandler::defaultHandler(const atools::fs::NavDatabaseProgress& inf)
 
 QString ProgressHandler::numbersAsString(const atools::fs::NavDatabaseProgress& inf)
 {
-  return QString("%1 of %2 (%3 %)").arg(inf.current).arg(inf.total).arg(100 * info.current / info.total);
+  return QString("%1 of %2 (%3 %)").arg(inf.current).arg(inf.total).
+         arg(inf.total > 0 ? 100 * inf.current / inf.total : 0);
 }
 
 } // namespace fs
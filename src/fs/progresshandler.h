@@ -21,6 +21,11 @@
 #include "fs/navdatabaseprogress.h"
 #include "fs/navdatabaseoptions.h"
 
+#include <QElapsedTimer>
+#include <QMutex>
+
+#include <atomic>
+
 namespace atools {
 namespace fs {
 namespace scenery {
@@ -29,6 +34,10 @@ class SceneryArea;
 
 /*
  * Progress handler. Fills the NavDatabaseProgress object with information and calls the progress callback.
+ *
+ * Counters are atomic and can be increased from any thread. Reports for BGL files and updates are coalesced
+ * and the callbacks are called at most once per report interval by the thread which is due. Other threads
+ * do not wait for a running callback and continue.
  */
 class ProgressHandler
 {
@@ -79,111 +88,145 @@ public:
   /* Set current number of BGL files */
   void setNumFiles(int value)
   {
-    info.numFiles = value;
+    numFiles.store(value, std::memory_order_relaxed);
   }
 
   void setNumAirports(int value)
   {
-    info.numAirports = value;
+    numAirports.store(value, std::memory_order_relaxed);
   }
 
   void setNumNamelists(int value)
   {
-    info.numNamelists = value;
+    numNamelists.store(value, std::memory_order_relaxed);
   }
 
   void setNumVors(int value)
   {
-    info.numVors = value;
+    numVors.store(value, std::memory_order_relaxed);
   }
 
   void setNumIls(int value)
   {
-    info.numIls = value;
+    numIls.store(value, std::memory_order_relaxed);
   }
 
   void setNumNdbs(int value)
   {
-    info.numNdbs = value;
+    numNdbs.store(value, std::memory_order_relaxed);
   }
 
   void setNumMarker(int value)
   {
-    info.numMarker = value;
+    numMarker.store(value, std::memory_order_relaxed);
   }
 
   void setNumBoundaries(int value)
   {
-    info.numBoundaries = value;
+    numBoundaries.store(value, std::memory_order_relaxed);
   }
 
   void setNumWaypoints(int value)
   {
-    info.numWaypoints = value;
+    numWaypoints.store(value, std::memory_order_relaxed);
   }
 
   void setNumObjectsWritten(int value)
   {
-    info.numObjectsWritten = value;
+    numObjectsWritten.store(value, std::memory_order_relaxed);
   }
 
   void incNumFiles(int value = 1)
   {
-    info.numFiles += value;
+    numFiles.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumAirports(int value = 1)
   {
-    info.numAirports += value;
+    numAirports.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumNamelists(int value = 1)
   {
-    info.numNamelists += value;
+    numNamelists.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumVors(int value = 1)
   {
-    info.numVors += value;
+    numVors.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumIls(int value = 1)
   {
-    info.numIls += value;
+    numIls.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumNdbs(int value = 1)
   {
-    info.numNdbs += value;
+    numNdbs.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumMarker(int value = 1)
   {
-    info.numMarker += value;
+    numMarker.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumBoundaries(int value = 1)
   {
-    info.numBoundaries += value;
+    numBoundaries.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumWaypoints(int value = 1)
   {
-    info.numWaypoints += value;
+    numWaypoints.fetch_add(value, std::memory_order_relaxed);
   }
 
   void incNumObjectsWritten(int value = 1)
   {
-    info.numObjectsWritten += value;
+    numObjectsWritten.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  /* Cancellation token. Cheap to poll from worker threads. Set if a callback returned true or by calling cancel(). */
+  bool isCanceled() const
+  {
+    return canceled.load(std::memory_order_relaxed);
+  }
+
+  /* Cancel from any thread. All following reports return true. */
+  void cancel()
+  {
+    canceled.store(true, std::memory_order_relaxed);
+  }
+
+  /* Minimum time between two calls of the callbacks for BGL file reports and updates.
+   * Scenery areas, other actions and finish are always reported. 0 reports all. */
+  void setReportIntervalMs(int value)
+  {
+    reportIntervalMs = value;
   }
 
 private:
   void defaultHandler(const atools::fs::NavDatabaseProgress& inf);
 
+  /* true if report interval is elapsed since last callback */
+  bool isReportDue() const;
+
   atools::fs::NavDatabaseOptions::ProgressCallbackType handler = nullptr;
 
+  /* Copy of the counters and text as passed to the callbacks. Guarded by mutex. */
   atools::fs::NavDatabaseProgress info;
+  QMutex mutex;
+
+  std::atomic_int numFiles{0}, numAirports{0}, numNamelists{0}, numVors{0}, numIls{0}, numNdbs{0}, numMarker{0},
+                  numBoundaries{0}, numWaypoints{0}, numObjectsWritten{0}, numErrors{0}, current{0}, total{0};
+  std::atomic_bool canceled{false};
+
+  /* Time of last callback since start of timer */
+  std::atomic<qint64> lastReportMs{0};
+  QElapsedTimer timer;
+  int reportIntervalMs = 50;
 
+  /* Copy counters into info and call handlers. Mutex has to be locked. */
   bool callHandler();
 
   QString numbersAsString(const atools::fs::NavDatabaseProgress& inf);
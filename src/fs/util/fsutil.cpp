@@ -16,62 +16,197 @@
 *****************************************************************************/
 
 #include "fs/util/fsutil.h"
+#include "fs/util/namematcher.h"
 #include "atools.h"
 #include "geo/calculations.h"
 
 #include <QRegularExpression>
 #include <QSet>
+#include <QVarLengthArray>
 
 namespace atools {
 namespace fs {
 namespace util {
 
-// Closed airport by name
-static const QRegularExpression REGEXP_CLOSED(QLatin1Literal("(\\[X\\]|\\bCLSD\\b|\\bCLOSED\\b)"));
-const static QRegularExpression REGEXP_DIGIT("\\d");
-const static QRegularExpression REGEXP_WHITESPACE("\\s");
-
 /* ICAO speed and altitude matches */
 const static QRegularExpression REGEXP_SPDALT("^([NMK])(\\d{2,4})(([FSAM])(\\d{2,4}))?$");
 const static QRegularExpression REGEXP_SPDALT_ALL("^([NMK])(\\d{3,4})([FSAM])(\\d{3,4})$");
 
-// Look for military designator words
-static const QVector<QRegularExpression> REGEXP_MIL({
-        QRegularExpression(QLatin1Literal("\\bAAF\\b")),
-        QRegularExpression(QLatin1Literal("\\bAB\\b")),
-        QRegularExpression(QLatin1Literal("\\bAF\\b")),
-        QRegularExpression(QLatin1Literal("\\bAFB\\b")),
-        QRegularExpression(QLatin1Literal("\\bAFS\\b")),
-        QRegularExpression(QLatin1Literal("\\bAHP\\b")),
-        QRegularExpression(QLatin1Literal("\\bAIR BASE\\b")),
-        QRegularExpression(QLatin1Literal("\\bAIRBASE\\b")),
-        QRegularExpression(QLatin1Literal("\\bAIR FORCE\\b")),
-        QRegularExpression(QLatin1Literal("\\bANGB\\b")),
-        QRegularExpression(QLatin1Literal("\\bARB\\b")),
-        QRegularExpression(QLatin1Literal("\\bARMY\\b")),
-        // QRegularExpression(QLatin1Literal("\\bGTS\\b")), not an airbase
-        QRegularExpression(QLatin1Literal("\\bLRRS\\b")),
-        QRegularExpression(QLatin1Literal("\\bPMRF\\b")),
-        QRegularExpression(QLatin1Literal("\\bMCAF\\b")),
-        QRegularExpression(QLatin1Literal("\\bMCALF\\b")),
-        QRegularExpression(QLatin1Literal("\\bMCAS\\b")),
-        QRegularExpression(QLatin1Literal("\\bMIL\\b")),
-        QRegularExpression(QLatin1Literal("\\bMILITARY\\b")),
-        QRegularExpression(QLatin1Literal("\\bNAF\\b")),
-        QRegularExpression(QLatin1Literal("\\bNALF\\b")),
-        QRegularExpression(QLatin1Literal("\\bNAS\\b")),
-        QRegularExpression(QLatin1Literal("\\bNAVAL\\b")),
-        QRegularExpression(QLatin1Literal("\\bNAVY\\b")),
-        QRegularExpression(QLatin1Literal("\\bNAWS\\b")),
-        QRegularExpression(QLatin1Literal("\\bNOLF\\b")),
-        QRegularExpression(QLatin1Literal("\\bNS\\b")),
-        QRegularExpression(QLatin1Literal("\\bNSF\\b")),
-        QRegularExpression(QLatin1Literal("\\bRAF\\b")),
-        QRegularExpression(QLatin1Literal("\\bRNAS\\b")),
-        QRegularExpression(QLatin1Literal("\\bROYAL MARINES\\b")),
-        QRegularExpression(QLatin1Literal("\\bAFLD\\b"))
+/* Flags attached to patterns in the name matchers */
+enum NamePatternFlag
+{
+  NAME_MILITARY = 1 << 0, /* Military designator word */
+  NAME_CLOSED = 1 << 1, /* Closed indicator */
+  NAME_CAP_UPPER = 1 << 2, /* Word is converted to upper case when capitalizing */
+  NAME_CAP_IGNORE = 1 << 3 /* Upper case word is left as is when capitalizing */
+};
+
+// Look for military designator words - matched as whole words like regular expression "\bAAF\b"
+static const QStringList NAMES_MIL({
+        "AAF", "AB", "AF", "AFB", "AFS", "AHP", "AIR BASE", "AIRBASE", "AIR FORCE", "ANGB", "ARB", "ARMY",
+        // "GTS", not an airbase
+        "LRRS", "PMRF", "MCAF", "MCALF", "MCAS", "MIL", "MILITARY", "NAF", "NALF", "NAS", "NAVAL", "NAVY", "NAWS",
+        "NOLF", "NS", "NSF", "RAF", "RNAS", "ROYAL MARINES", "AFLD"
+      });
+
+// Closed airport by name - words or "[X]" anywhere
+static const QStringList NAMES_CLOSED_WORDS({"CLSD", "CLOSED"});
+static const QLatin1String NAME_CLOSED_INDICATOR("[X]");
+
+// Converted to upper case in airport names
+static const QStringList NAMES_CAP_UPPER({
+        // Military designators to upper
+        "AAF", "AB", "AF", "AFB", "AFS", "AHP", "ANGB", "ARB", "GTS", "LRRS", "PMRF", "MCAF", "MCALF", "MCAS", "NAF",
+        "NALF", "NAS", "NWS", "NAWS", "NOLF", "NS", "NSB", "NSY", "NSWC", "NSF", "RAF", "RNAS", "AFLD",
+
+        // Not military but an acronym
+        "USFS"
       });
 
+// Ignore aviation acronyms in capitalization of navaid names
+static const QStringList NAMES_CAP_IGNORE({
+        // Navaids
+        "VOR", "VORDME", "TACAN", "VOT", "VORTAC", "DME", "NDB", "GA", "RNAV", "GPS",
+        "ILS", "NDBDME",
+        // Frequencies
+        "ATIS", "AWOS", "ASOS", "AWIS", "CTAF", "FSS", "CAT", "LOC", "I", "II", "III",
+        // Navaid and precision approach types
+        "H", "HH", "MH", "VASI", "PAPI",
+        // Airspace abbreviations
+        "ALS", "ATZ", "CAE", "CTA", "CTR", "FIR", "UIR", "FIZ", "FTZ",
+        "MATZ", "MOA", "RMZ", "TIZ", "TMA", "TMZ", "TRA", "TRSA", "TWEB", "ARSA",
+        "AAS", "CARS", "FIS", "AFIS", "ATF", "VDF", "PCL", "RCO", "RCAG",
+        "NOTAM", "CERAP", "ARTCC",
+      });
+
+/* Matcher for airport name classification and capitalization. Built once on first use. */
+static const NameMatcher& airportNameMatcher()
+{
+  static const NameMatcher matcher = [] {
+    NameMatcher m;
+    for(const QString& name : NAMES_MIL)
+      m.addPattern(name, NAME_MILITARY, NameMatcher::ASCII_WORD);
+
+    for(const QString& name : NAMES_CLOSED_WORDS)
+      m.addPattern(name, NAME_CLOSED, NameMatcher::ASCII_WORD);
+    m.addPattern(NAME_CLOSED_INDICATOR, NAME_CLOSED, NameMatcher::NO_BOUNDARY);
+
+    for(const QString& name : NAMES_CAP_UPPER)
+      m.addPattern(name, NAME_CAP_UPPER, NameMatcher::LETTER_OR_NUMBER);
+    m.build();
+    return m;
+  } ();
+  return matcher;
+}
+
+/* Matcher for navaid and airspace name capitalization. Built once on first use. */
+static const NameMatcher& navNameMatcher()
+{
+  static const NameMatcher matcher = [] {
+    NameMatcher m;
+    for(const QString& name : NAMES_CAP_IGNORE)
+      m.addPattern(name, NAME_CAP_IGNORE, NameMatcher::LETTER_OR_NUMBER);
+    m.build();
+    return m;
+  } ();
+  return matcher;
+}
+
+/* Append capitalized word [start, end) of str to result. Same rules as atools::capWord().
+ * Avoids temporary strings for pure ASCII words. */
+static void capWordAppend(QString& result, const QString& str, int start, int end, QChar lastSep, int flags)
+{
+  bool ascii = true, upperAscii = true;
+  for(int i = start; i < end; i++)
+  {
+    ushort u = str.at(i).unicode();
+    ascii &= u < 128;
+    upperAscii &= (u >= 'A' && u <= 'Z') || (u >= '0' && u <= '9');
+  }
+
+  if(flags & NAME_CAP_UPPER)
+  {
+    for(int i = start; i < end; i++)
+      result.append(str.at(i).toUpper());
+  }
+  else if((flags & NAME_CAP_IGNORE) && upperAscii)
+    // Ignore is case sensitive - keep only if word is already in upper case
+    result.append(str.midRef(start, end - start));
+  else if(lastSep == '\'' && end - start == 1)
+    // Convert all letters after an apostrophe to lower case (St. Mary's)
+    result.append(str.at(start).toLower());
+  else if(ascii)
+  {
+    result.append(str.at(start).toUpper());
+    for(int i = start + 1; i < end; i++)
+      result.append(str.at(i).toLower());
+  }
+  else
+  {
+    // Use full case mapping for other characters
+    QString word = str.mid(start, end - start).toLower();
+    word[0] = word.at(0).toUpper();
+    result.append(word);
+  }
+}
+
+/* Capitalize all words like atools::capString() and use the matcher to find upper case or ignored words.
+ * Returns all flags found by the matcher in matchFlags. */
+static QString capName(const QString& str, const NameMatcher& matcher, int& matchFlags)
+{
+  matchFlags = 0;
+  if(str.isEmpty())
+    return str;
+
+  // Collect start positions and flags of all words which need special treatment
+  // Matches are always whole words since boundary mode is LETTER_OR_NUMBER
+  struct SpecialWord
+  {
+    int start, flags;
+  };
+  QVarLengthArray<SpecialWord, 16> specialWords;
+  matcher.scan(str, [&specialWords, &matchFlags](int start, int, int flags) -> bool {
+    matchFlags |= flags;
+    if(flags & (NAME_CAP_UPPER | NAME_CAP_IGNORE))
+      specialWords.append({start, flags});
+    return true;
+  });
+
+  QString retval;
+  retval.reserve(str.size());
+  QChar lastSep;
+  int size = str.size(), specialIndex = 0, i = 0;
+  while(i < size)
+  {
+    QChar c = str.at(i);
+    if(!c.isLetterOrNumber())
+    {
+      // Separators are copied and underscores replaced
+      retval.append(c == '_' ? QChar(' ') : c);
+      lastSep = c;
+      i++;
+    }
+    else
+    {
+      int start = i;
+      while(i < size && str.at(i).isLetterOrNumber())
+        i++;
+
+      // Find flags for this word if any
+      int flags = 0;
+      while(specialIndex < specialWords.size() && specialWords.at(specialIndex).start < start)
+        specialIndex++;
+      if(specialIndex < specialWords.size() && specialWords.at(specialIndex).start == start)
+        flags = specialWords.at(specialIndex).flags;
+
+      // Last word uses the second last character as separator like capString()
+      QChar sep = i == size ? str.at(size >= 2 ? size - 2 : 0) : lastSep;
+      capWordAppend(retval, str, start, i, sep, flags);
+    }
+  }
+  return retval;
+}
+
 static const QHash<QString, QString> NAME_CODE_MAP(
       {
         {"A124", "Antonov AN-124 Ruslan"},
@@ -378,57 +513,46 @@ int calculateAirportRatingXp(bool isAddon, bool is3D, bool hasTower, int numTaxi
 
 bool isNameClosed(const QString& airportName)
 {
-  return REGEXP_CLOSED.match(airportName.toUpper()).hasMatch();
+  return airportNameMatcher().matchesAny(airportName, NAME_CLOSED);
 }
 
 bool isNameMilitary(const QString& airportName)
 {
   // Check if airport is military
-  for(const QRegularExpression& s : REGEXP_MIL)
-  {
-    if(s.match(airportName.toUpper()).hasMatch())
-      return true;
-  }
-  return false;
+  return airportNameMatcher().matchesAny(airportName, NAME_MILITARY);
 }
 
 QString capNavString(const QString& str)
 {
-  if(str.contains(REGEXP_DIGIT) && !str.contains(REGEXP_WHITESPACE))
+  bool digit = false, whitespace = false;
+  for(QChar c : str)
+  {
+    ushort u = c.unicode();
+    digit |= u >= '0' && u <= '9';
+    whitespace |= u == ' ' || (u >= '\t' && u <= '\r');
+  }
+
+  if(digit && !whitespace)
     // Do not capitalize words that contains numbers but not spaces (airspace names)
     return str;
 
-  // Ignore aviation acronyms in capitalization
-  const static QSet<QString> ignore({
-          // Navaids
-          "VOR", "VORDME", "TACAN", "VOT", "VORTAC", "DME", "NDB", "GA", "RNAV", "GPS",
-          "ILS", "NDBDME",
-          // Frequencies
-          "ATIS", "AWOS", "ASOS", "AWIS", "CTAF", "FSS", "CAT", "LOC", "I", "II", "III",
-          // Navaid and precision approach types
-          "H", "HH", "MH", "VASI", "PAPI",
-          // Airspace abbreviations
-          "ALS", "ATZ", "CAE", "CTA", "CTR", "FIR", "UIR", "FIZ", "FTZ",
-          "MATZ", "MOA", "RMZ", "TIZ", "TMA", "TMZ", "TRA", "TRSA", "TWEB", "ARSA",
-          "AAS", "CARS", "FIS", "AFIS", "ATF", "VDF", "PCL", "RCO", "RCAG",
-          "NOTAM", "CERAP", "ARTCC",
-        });
-
-  return atools::capString(str, {}, {}, ignore);
+  int flags;
+  return capName(str, navNameMatcher(), flags);
 }
 
 QString capAirportName(const QString& str)
 {
-  const static QSet<QString> upper({
-          // Military designators to upper
-          "AAF", "AB", "AF", "AFB", "AFS", "AHP", "ANGB", "ARB", "GTS", "LRRS", "PMRF", "MCAF", "MCALF", "MCAS", "NAF",
-          "NALF", "NAS", "NWS", "NAWS", "NOLF", "NS", "NSB", "NSY", "NSWC", "NSF", "RAF", "RNAS", "AFLD",
-
-          // Not military but an acronym
-          "USFS"
-        });
+  int flags;
+  return capName(str, airportNameMatcher(), flags);
+}
 
-  return atools::capString(str, upper);
+QString capAirportName(const QString& str, bool& military, bool& closed)
+{
+  int flags;
+  QString retval = capName(str, airportNameMatcher(), flags);
+  military = flags & NAME_MILITARY;
+  closed = flags & NAME_CLOSED;
+  return retval;
 }
 
 QString adjustFsxUserWpName(QString name, int length)
@@ -52,6 +52,10 @@ QString capNavString(const QString& str);
 /* Capitalize airport name making special designators (AFB, ...) upper case */
 QString capAirportName(const QString& str);
 
+/* Same as above but also detects military designators and closed indicators like isNameMilitary() and
+ * isNameClosed() in the same pass */
+QString capAirportName(const QString& str, bool& military, bool& closed);
+
 /* Limits ident to upper case characters and digits and trims length to five.
  * Returns N with following number if empty. */
 QString adjustIdent(QString ident, int length = 5, int id = -1);
@@ -0,0 +1,150 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/util/namematcher.h"
+
+#include <QDebug>
+
+#include <algorithm>
+
+namespace atools {
+namespace fs {
+namespace util {
+
+NameMatcher::NameMatcher()
+{
+  // Root node
+  addNode();
+}
+
+int NameMatcher::addNode()
+{
+  Node node;
+  std::fill(node.next, node.next + NUM_SYMBOLS, -1);
+  nodes.append(node);
+  return nodes.size() - 1;
+}
+
+void NameMatcher::addPattern(const QString& pattern, int flags, Boundary boundary)
+{
+  Q_ASSERT(!built);
+
+  if(pattern.isEmpty())
+    return;
+
+  // Insert into trie
+  int state = 0;
+  for(QChar c : pattern)
+  {
+    int sym = symbol(c);
+    if(sym == -1)
+    {
+      qWarning() << Q_FUNC_INFO << "Invalid character in pattern" << pattern;
+      return;
+    }
+
+    if(nodes.at(state).next[sym] == -1)
+    {
+      int node = addNode();
+      nodes[state].next[sym] = node;
+    }
+    state = nodes.at(state).next[sym];
+  }
+
+  // Look for a duplicate having the same boundary mode and merge flags
+  for(int p = nodes.at(state).pattern; p != -1; p = patterns.at(p).next)
+  {
+    if(patterns.at(p).boundary == boundary)
+    {
+      patterns[p].flags |= flags;
+      return;
+    }
+  }
+
+  // Prepend to list of patterns ending at this node
+  patterns.append({pattern.size(), flags, boundary, nodes.at(state).pattern});
+  nodes[state].pattern = patterns.size() - 1;
+}
+
+void NameMatcher::build()
+{
+  Q_ASSERT(!built);
+
+  // Breadth first traversal to calculate failure links and complete the transition table
+  QVector<int> queue;
+  queue.reserve(nodes.size());
+
+  Node& root = nodes[0];
+  for(int sym = 0; sym < NUM_SYMBOLS; sym++)
+  {
+    if(root.next[sym] == -1)
+      root.next[sym] = 0;
+    else
+    {
+      nodes[root.next[sym]].fail = 0;
+      queue.append(root.next[sym]);
+    }
+  }
+
+  for(int i = 0; i < queue.size(); i++)
+  {
+    int state = queue.at(i);
+
+    // Output link points to the nearest node in the failure chain which ends a pattern
+    int fail = nodes.at(state).fail;
+    nodes[state].outLink = nodes.at(fail).pattern != -1 ? fail : nodes.at(fail).outLink;
+
+    for(int sym = 0; sym < NUM_SYMBOLS; sym++)
+    {
+      int child = nodes.at(state).next[sym];
+      if(child == -1)
+        // Missing transition - use the one of the failure node which is already complete
+        nodes[state].next[sym] = nodes.at(fail).next[sym];
+      else
+      {
+        nodes[child].fail = nodes.at(fail).next[sym];
+        queue.append(child);
+      }
+    }
+  }
+
+  built = true;
+}
+
+int NameMatcher::matchFlags(const QString& str) const
+{
+  int flags = 0;
+  scan(str, [&flags](int, int, int patternFlags) -> bool {
+    flags |= patternFlags;
+    return true;
+  });
+  return flags;
+}
+
+bool NameMatcher::matchesAny(const QString& str, int flags) const
+{
+  bool found = false;
+  scan(str, [&found, flags](int, int, int patternFlags) -> bool {
+    found = (patternFlags & flags) != 0;
+    return !found;
+  });
+  return found;
+}
+
+} // namespace util
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,177 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_UTIL_NAMEMATCHER_H
+#define ATOOLS_FS_UTIL_NAMEMATCHER_H
+
+#include <QString>
+#include <QVector>
+
+namespace atools {
+namespace fs {
+namespace util {
+
+/*
+ * Case insensitive multi pattern matcher (Aho-Corasick automaton) for airport and navaid names.
+ * Finds all occurrences of all patterns in a single pass over the string without creating temporary strings.
+ *
+ * Patterns are limited to printable ASCII characters from space to underscore after conversion to upper case.
+ * Each pattern carries user defined flags and a word boundary mode which is checked when reporting matches.
+ *
+ * Add all patterns first and call build() once before scanning. Scanning is thread safe after building.
+ */
+class NameMatcher
+{
+public:
+  /* Defines what is considered a word boundary for a pattern */
+  enum Boundary
+  {
+    NO_BOUNDARY, /* Match anywhere */
+    ASCII_WORD, /* Like regular expression \b - characters A-Z, a-z, 0-9 and _ are part of a word */
+    LETTER_OR_NUMBER /* Like atools::capString() - all characters that are not letter or number separate words */
+  };
+
+  NameMatcher();
+
+  /* Add a pattern. flags are passed to the callback in scan(). Must be called before build(). */
+  void addPattern(const QString& pattern, int flags, Boundary boundary);
+
+  /* Build transition table and failure links. */
+  void build();
+
+  /* Calls callback(int start, int end, int flags) for each match where end is exclusive.
+   * Matches are reported in order of end position. Scanning stops if callback returns false. */
+  template<typename FUNC>
+  void scan(const QString& str, FUNC callback) const;
+
+  /* Returns all flags or'ed together that were found in the string */
+  int matchFlags(const QString& str) const;
+
+  /* Returns true if any pattern having at least one of the given flags is found */
+  bool matchesAny(const QString& str, int flags) const;
+
+  int numPatterns() const
+  {
+    return patterns.size();
+  }
+
+private:
+  /* Printable ASCII from space (32) up to underscore (95) after upper case conversion */
+  static const int NUM_SYMBOLS = 64;
+  static const ushort FIRST_SYMBOL = 32;
+
+  struct Pattern
+  {
+    int length, flags;
+    Boundary boundary;
+    int next; /* Next pattern ending at the same node but having a different boundary mode or -1 */
+  };
+
+  struct Node
+  {
+    int next[NUM_SYMBOLS];
+    int fail = 0, /* Failure link to longest proper suffix node */
+        outLink = -1, /* Next node in failure chain which ends a pattern */
+        pattern = -1; /* Pattern ending at this node or -1 */
+  };
+
+  /* Converts character to automaton symbol or -1 if not part of the alphabet */
+  static int symbol(QChar c)
+  {
+    ushort u = c.unicode();
+    if(u >= 'a' && u <= 'z')
+      u -= 'a' - 'A';
+    else if(u > 127)
+      // Try to fold non ASCII characters like dotless i
+      u = c.toUpper().unicode();
+
+    if(u >= FIRST_SYMBOL && u < FIRST_SYMBOL + NUM_SYMBOLS)
+      return u - FIRST_SYMBOL;
+    else
+      return -1;
+  }
+
+  static bool isWordChar(QChar c, Boundary boundary)
+  {
+    if(boundary == ASCII_WORD)
+    {
+      ushort u = c.unicode();
+      return (u >= 'A' && u <= 'Z') || (u >= 'a' && u <= 'z') || (u >= '0' && u <= '9') || u == '_';
+    }
+    else
+      return c.isLetterOrNumber();
+  }
+
+  bool isBoundary(const QString& str, int start, int end, Boundary boundary) const
+  {
+    if(boundary == NO_BOUNDARY)
+      return true;
+
+    return (start == 0 || !isWordChar(str.at(start - 1), boundary)) &&
+           (end == str.size() || !isWordChar(str.at(end), boundary));
+  }
+
+  int addNode();
+
+  QVector<Node> nodes;
+  QVector<Pattern> patterns;
+  bool built = false;
+};
+
+template<typename FUNC>
+void NameMatcher::scan(const QString& str, FUNC callback) const
+{
+  Q_ASSERT(built);
+
+  const Node *nodeData = nodes.constData();
+  int state = 0;
+  for(int i = 0; i < str.size(); i++)
+  {
+    int sym = symbol(str.at(i));
+    if(sym == -1)
+    {
+      // Character is not part of any pattern - back to root
+      state = 0;
+      continue;
+    }
+
+    state = nodeData[state].next[sym];
+
+    // Report all patterns ending here by following the output links
+    int out = nodeData[state].pattern != -1 ? state : nodeData[state].outLink;
+    while(out != -1)
+    {
+      for(int p = nodeData[out].pattern; p != -1; p = patterns.at(p).next)
+      {
+        const Pattern& pattern = patterns.at(p);
+        int start = i + 1 - pattern.length;
+        if(isBoundary(str, start, i + 1, pattern.boundary))
+        {
+          if(!callback(start, i + 1, pattern.flags))
+            return;
+        }
+      }
+      out = nodeData[out].outLink;
+    }
+  }
+}
+
+} // namespace util
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_UTIL_NAMEMATCHER_H
@@ -19,12 +19,83 @@
 #include "util/httpdownloader.h"
 #include "fs/weather/weathertypes.h"
 
+#include <QThread>
+
 namespace atools {
 namespace fs {
 namespace weather {
 
-WeatherNetDownload::WeatherNetDownload(QObject *parent, int indexSize, bool verboseLogging)
-  : QObject(parent), index(indexSize), verbose(verboseLogging)
+/*
+ * Parses the downloaded METAR file, merges it into a copy of the previous reports and builds a new index
+ * in a background thread.
+ * Uses only a copy of the coordinate cache and does not call the fetch function which
+ * usually accesses the database. Stations missing in the cache are collected instead.
+ */
+class MetarIndexBuilder :
+  public QThread
+{
+public:
+  MetarIndexBuilder(const QByteArray& metarData, const QHash<QString, QString>& previousMetars,
+                    const QHash<QString, atools::geo::Pos>& stationPositions, int indexSize)
+    : metarMap(previousMetars), data(metarData), positions(stationPositions),
+    index(new atools::geo::SimpleSpatialIndex<QString, QString>(indexSize))
+  {
+  }
+
+  virtual ~MetarIndexBuilder() override
+  {
+    delete index;
+  }
+
+  /* Take ownership of the new index */
+  atools::geo::SimpleSpatialIndex<QString, QString> *takeIndex()
+  {
+    atools::geo::SimpleSpatialIndex<QString, QString> *retval = index;
+    index = nullptr;
+    return retval;
+  }
+
+  /* Previous reports with the reports from the new data added or replaced */
+  QHash<QString, QString> metarMap;
+
+  /* Stations which are not in the coordinate cache */
+  QStringList missingStations;
+
+private:
+  virtual void run() override;
+
+  QByteArray data;
+  QHash<QString, atools::geo::Pos> positions;
+  atools::geo::SimpleSpatialIndex<QString, QString> *index;
+};
+
+// AGGH 161200Z 14002KT 9999 FEW016 25/24 Q1010
+// AYNZ 160800Z 09005G10KT 9999 SCT030 BKN ABV050 27/24 Q1007 RMK
+// AYPY 160700Z 28010KT 9999 SCT025 OVC050 28/23 Q1008 RMK/ BUILD UPS TO S/W
+void MetarIndexBuilder::run()
+{
+  QTextStream stream(data, QIODevice::ReadOnly | QIODevice::Text);
+
+  while(!stream.atEnd())
+  {
+    QString line = stream.readLine().simplified();
+    metarMap.insert(line.section(' ', 0, 0), line);
+  }
+
+  for(auto it = metarMap.constBegin(); it != metarMap.constEnd(); ++it)
+  {
+    auto posIt = positions.constFind(it.key());
+    if(posIt == positions.constEnd())
+      missingStations.append(it.key());
+    else if(posIt.value().isValid())
+      index->insert(it.key(), it.value(), posIt.value());
+  }
+}
+
+// ==========================================================================
+WeatherNetDownload::WeatherNetDownload(QObject *parent, int indexSizeParam, bool verboseLogging)
+  : QObject(parent), index(new MetarSpatialIndex(indexSizeParam)), indexSize(indexSizeParam),
+  verbose(verboseLogging)
 {
   downloader = new atools::util::HttpDownloader(parent, verboseLogging);
 
@@ -34,7 +105,15 @@ WeatherNetDownload::WeatherNetDownload(QObject *parent, int indexSize, bool verb
 
 WeatherNetDownload::~WeatherNetDownload()
 {
+  if(indexBuilder != nullptr)
+  {
+    disconnect(indexBuilder, &QThread::finished, this, &WeatherNetDownload::indexBuilderFinished);
+    indexBuilder->wait();
+    delete indexBuilder;
+  }
+
   delete downloader;
+  delete index;
 }
 
 atools::fs::weather::MetarResult WeatherNetDownload::getMetar(const QString& airportIcao, const atools::geo::Pos& pos)
@@ -42,16 +121,17 @@ atools::fs::weather::MetarResult WeatherNetDownload::getMetar(const QString& air
   atools::fs::weather::MetarResult result;
   result.init(airportIcao, pos);
 
-  if(index.isEmpty())
+  if(index->isEmpty())
   {
-    if(!downloader->isDownloading())
+    // Do not download again while the first index is built or data is waiting for it
+    if(!downloader->isDownloading() && indexBuilder == nullptr && pendingData.isEmpty())
       downloader->startDownload();
     // else already downloading - message will be sent for update once done
   }
   else
   {
     QString data;
-    QString foundKey = index.getTypeOrNearest(data, airportIcao, pos);
+    QString foundKey = index->getTypeOrNearest(data, airportIcao, pos);
     if(!foundKey.isEmpty())
     {
       if(foundKey == airportIcao)
@@ -74,9 +154,11 @@ void WeatherNetDownload::downloadFinished(const QByteArray& data, QString url)
   if(verbose)
     qDebug() << Q_FUNC_INFO << "url" << url << "data size" << data.size();
 
-  parseFile(data);
-
-  emit weatherUpdated();
+  if(indexBuilder != nullptr)
+    // Still building - keep only the latest data
+    pendingData = data;
+  else
+    startIndexBuilder(data);
 }
 
 void WeatherNetDownload::downloadFailed(const QString& error, int errorCode, QString url)
@@ -93,35 +175,102 @@ void WeatherNetDownload::setUpdatePeriod(int seconds)
 
 void WeatherNetDownload::updateIndex()
 {
-  for(auto it = metarMap.begin(); it != metarMap.end(); ++it)
-  {
-    atools::geo::Pos pos = fetchAirportCoords(it.key());
-    if(pos.isValid())
-      index.insert(it.key(), it.value(), pos);
-  }
+  // Simulator database might have changed
+  stationPosCache.clear();
+
+  if(indexBuilder != nullptr)
+    // Running thread uses a copy of the old cache - rebuild when it is done
+    rebuildPending = true;
+  else
+    rebuildIndex();
+}
+
+void WeatherNetDownload::rebuildIndex()
+{
+  // Calls the fetch function for all stations not in the cache in this thread
+  MetarSpatialIndex *newIndex = new MetarSpatialIndex(indexSize);
+  for(auto it = metarMap.constBegin(); it != metarMap.constEnd(); ++it)
+    insertStation(newIndex, it.key(), it.value());
+  swapIndex(newIndex);
 
   if(verbose)
-    qDebug() << Q_FUNC_INFO << "Updated" << index.size() << "metar positions";
+    qDebug() << Q_FUNC_INFO << "Updated" << index->size() << "metar positions";
 }
 
-// AGGH 161200Z 14002KT 9999 FEW016 25/24 Q1010
-// AYNZ 160800Z 09005G10KT 9999 SCT030 BKN ABV050 27/24 Q1007 RMK
-// AYPY 160700Z 28010KT 9999 SCT025 OVC050 28/23 Q1008 RMK/ BUILD UPS TO S/W
-void WeatherNetDownload::parseFile(const QByteArray& data)
+void WeatherNetDownload::startIndexBuilder(const QByteArray& data)
 {
-  QTextStream stream(data, QIODevice::ReadOnly | QIODevice::Text);
+  refreshTimer.start();
 
-  while(!stream.atEnd())
+  indexBuilder = new MetarIndexBuilder(data, metarMap, stationPosCache, indexSize);
+  connect(indexBuilder, &QThread::finished, this, &WeatherNetDownload::indexBuilderFinished);
+  indexBuilder->start();
+}
+
+void WeatherNetDownload::indexBuilderFinished()
+{
+  // Signal might arrive shortly before the thread has ended
+  indexBuilder->wait();
+
+  qint64 parseTimeMs = refreshTimer.elapsed();
+  metarMap.swap(indexBuilder->metarMap);
+
+  if(rebuildPending)
   {
-    QString line = stream.readLine().simplified();
-    metarMap.insert(line.section(' ', 0, 0), line);
+    // Simulator database changed while building - drop index and resolve all positions again
+    rebuildPending = false;
+    delete indexBuilder;
+    indexBuilder = nullptr;
+
+    rebuildIndex();
+    qDebug() << Q_FUNC_INFO << "Loaded" << metarMap.size() << "metars with rebuilt index," << index->size()
+             << "positions from" << downloader->getUrl() << "total" << refreshTimer.elapsed() << "ms";
   }
+  else
+  {
+    MetarSpatialIndex *newIndex = indexBuilder->takeIndex();
 
-  updateIndex();
+    // Resolve coordinates for new stations in this thread since the fetch function usually uses the database.
+    // This is synchronous and covers all stations on the first build.
+    for(const QString& ident : indexBuilder->missingStations)
+      insertStation(newIndex, ident, metarMap.value(ident));
 
-  if(verbose)
-    qDebug() << Q_FUNC_INFO << "Loaded" << data.size() << "bytes and" << metarMap.size()
-             << "metars from" << downloader->getUrl();
+    qDebug() << Q_FUNC_INFO << "Loaded" << metarMap.size() << "metars," << newIndex->size() << "positions,"
+             << indexBuilder->missingStations.size() << "new stations from" << downloader->getUrl()
+             << "parsing" << parseTimeMs << "ms, total" << refreshTimer.elapsed() << "ms";
+
+    delete indexBuilder;
+    indexBuilder = nullptr;
+
+    swapIndex(newIndex);
+  }
+
+  emit weatherUpdated();
+
+  if(!pendingData.isEmpty())
+  {
+    // Data arrived while building - start again
+    QByteArray data;
+    data.swap(pendingData);
+    startIndexBuilder(data);
+  }
+}
+
+void WeatherNetDownload::insertStation(MetarSpatialIndex *newIndex, const QString& ident, const QString& metar)
+{
+  auto it = stationPosCache.constFind(ident);
+  if(it == stationPosCache.constEnd())
+    // Also remember invalid positions to avoid looking up unknown stations again
+    it = stationPosCache.insert(ident, fetchAirportCoords != nullptr ? fetchAirportCoords(ident) : atools::geo::Pos());
+
+  if(it.value().isValid())
+    newIndex->insert(ident, metar, it.value());
+}
+
+void WeatherNetDownload::swapIndex(MetarSpatialIndex *newIndex)
+{
+  // Index is only accessed in this thread - replacing the pointer does not need locking
+  delete index;
+  index = newIndex;
 }
 
 } // namespace weather
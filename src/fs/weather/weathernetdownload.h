@@ -20,6 +20,8 @@
 
 #include "geo/simplespatialindex.h"
 
+#include <QElapsedTimer>
+
 namespace atools {
 namespace util {
 class HttpDownloader;
@@ -28,10 +30,18 @@ namespace fs {
 namespace weather {
 
 struct MetarResult;
+class MetarIndexBuilder;
 
 /*
  * Manages metar files that are download fully from the web like IVAO.
  * Has a timer that triggers a recurrent lookup.
+ *
+ * Downloaded files are parsed and the index is built in a background thread. The new index replaces
+ * the old one when done, so lookups never wait for a refresh. Airport coordinates are cached and only
+ * stations not seen before are resolved with the fetch function in the thread of this object.
+ *
+ * Note that the first build after start or after updateIndex() still calls the fetch function once for each
+ * station synchronously in the thread of this object since the cache is empty. Only later refreshes are cheap.
  */
 class WeatherNetDownload :
   public QObject
@@ -63,7 +73,10 @@ public:
   }
 
   /* Copy airports from the complete list to the index with coordinates.
-   * Copies only airports that exist in the current simulator database. */
+   * Copies only airports that exist in the current simulator database.
+   * Clears the coordinate cache. Call this if the simulator database changes.
+   * Resolves the coordinates of all stations synchronously. Delayed until the background thread is done if
+   * an index is currently built. */
   void updateIndex();
 
 signals:
@@ -73,17 +86,51 @@ signals:
   void weatherDownloadFailed(const QString& error, int errorCode, QString url);
 
 private:
+  typedef atools::geo::SimpleSpatialIndex<QString, QString> MetarSpatialIndex;
+
   void downloadFinished(const QByteArray& data, QString url);
   void downloadFailed(const QString& error, int errorCode, QString url);
-  void parseFile(const QByteArray& data);
+
+  /* Start background thread for parsing and index building */
+  void startIndexBuilder(const QByteArray& data);
+
+  /* Called in this object's thread when the background thread is done */
+  void indexBuilderFinished();
+
+  /* Build a new index from all reports using the coordinate cache and the fetch function */
+  void rebuildIndex();
+
+  /* Add station to new index if it exists in the simulator database. Uses and fills the coordinate cache. */
+  void insertStation(MetarSpatialIndex *newIndex, const QString& ident, const QString& metar);
+
+  /* Replace current index */
+  void swapIndex(MetarSpatialIndex *newIndex);
 
   std::function<atools::geo::Pos(const QString&)> fetchAirportCoords;
 
-  /* Contains all found airports but only latest reports */
+  /* Contains all found airports across all downloads but only latest reports */
   QHash<QString, QString> metarMap;
 
-  /* Contains all airports that are also available in the current simulator database. */
-  atools::geo::SimpleSpatialIndex<QString, QString> index;
+  /* Contains all airports that are also available in the current simulator database.
+   * Only accessed in the thread of this object. */
+  MetarSpatialIndex *index = nullptr;
+  int indexSize;
+
+  /* Airport coordinates from fetchAirportCoords. Contains invalid positions for unknown stations. */
+  QHash<QString, atools::geo::Pos> stationPosCache;
+
+  /* Running background thread or null */
+  atools::fs::weather::MetarIndexBuilder *indexBuilder = nullptr;
+
+  /* Data downloaded while the index was built - processed after the thread finished */
+  QByteArray pendingData;
+
+  /* updateIndex() was called while the background thread was running. Its index uses coordinates
+   * from the previous simulator database and has to be dropped. */
+  bool rebuildPending = false;
+
+  /* Measures time from download to index swap */
+  QElapsedTimer refreshTimer;
 
   atools::util::HttpDownloader *downloader = nullptr;
   bool verbose = false;
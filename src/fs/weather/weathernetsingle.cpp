@@ -33,21 +33,26 @@ namespace fs {
 namespace weather {
 
 WeatherNetSingle::WeatherNetSingle(QObject *parent, int timeoutMs, bool verboseLogging)
-  : QObject(parent), metarCache(timeoutMs), index(5000), verbose(verboseLogging)
+  : QObject(parent), metarCache(timeoutMs), noMetarCache(timeoutMs), index(5000), verbose(verboseLogging)
 {
   connect(&flushQueueTimer, &QTimer::timeout, this, &WeatherNetSingle::flushRequestQueue);
 
   flushQueueTimer.setInterval(1000);
   flushQueueTimer.start();
+
+  // Triggered when requests are delayed by the rate limit
+  rateLimitTimer.setSingleShot(true);
+  connect(&rateLimitTimer, &QTimer::timeout, this, &WeatherNetSingle::flushRequestQueue);
 }
 
 WeatherNetSingle::~WeatherNetSingle()
 {
   flushQueueTimer.stop();
+  rateLimitTimer.stop();
   delete indexDownloader;
 
   // Remove any outstanding requests
-  cancelReply();
+  cancelReplies();
 }
 
 MetarResult WeatherNetSingle::getMetar(const QString& airportIcao, const geo::Pos& pos)
@@ -84,18 +89,48 @@ QString WeatherNetSingle::getMetarInternal(const QString& airportIcao)
     QString *metar = metarCache.value(airportIcao);
     if(metar != nullptr)
       return QString(*metar);
-    else
+    else if(isRequestNeeded(airportIcao))
     {
-      if(!metarRequests.contains(airportIcao))
-      {
-        metarRequests.append(airportIcao);
-        flushRequestQueue();
-      }
+      metarRequests.append(airportIcao);
+      flushRequestQueue();
+    }
+    else if(metarRequests.contains(airportIcao) && metarRequests.last() != airportIcao)
+    {
+      // Already queued - move to end so it is sent next
+      metarRequests.removeAll(airportIcao);
+      metarRequests.append(airportIcao);
     }
   }
   return QString();
 }
 
+void WeatherNetSingle::prefetchMetars(const QStringList& airportIcaos)
+{
+  loadIndex();
+
+  if(requestUrl.isEmpty())
+    return;
+
+  for(const QString& icao : airportIcaos)
+  {
+    if((stationIndex.isEmpty() || stationIndex.contains(icao)) && !metarCache.contains(icao) &&
+       isRequestNeeded(icao))
+      // Insert at front to send after interactive requests - queue is processed from the end
+      metarRequests.prepend(icao);
+  }
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "queue size" << metarRequests.size();
+
+  flushRequestQueue();
+}
+
+bool WeatherNetSingle::isRequestNeeded(const QString& airportIcao)
+{
+  return !noMetarCache.contains(airportIcao) && !metarReplyIcaos.contains(airportIcao) &&
+         !metarRequests.contains(airportIcao);
+}
+
 void WeatherNetSingle::setStationIndexUrl(const QString& url,
                                           const std::function<void(QString& icao, QDateTime& lastUpdate,
                                                                    const QString& line)>& parseFunc)
@@ -109,12 +144,31 @@ void WeatherNetSingle::setStationIndexUrl(const QString& url,
 
 void WeatherNetSingle::flushRequestQueue()
 {
-  if(!metarRequests.isEmpty() && replyMetar == nullptr && !requestUrl.isEmpty())
+  if(requestUrl.isEmpty())
+    return;
+
+  if(verbose && !metarRequests.isEmpty())
+    qDebug() << Q_FUNC_INFO << "flushing queue" << metarRequests;
+
+  QString host = QUrl(requestUrl).host();
+  while(!metarRequests.isEmpty() && metarReplies.size() < maxParallelRequests)
   {
-    if(verbose)
-      qDebug() << Q_FUNC_INFO << "flushing queue" << metarRequests;
+    if(minRequestIntervalMs > 0)
+    {
+      // Delay request if the last one to this host was sent too recently
+      qint64 now = QDateTime::currentMSecsSinceEpoch();
+      qint64 waitMs = lastRequestTimeMs.value(host, 0) + minRequestIntervalMs - now;
+      if(waitMs > 0)
+      {
+        if(!rateLimitTimer.isActive())
+          rateLimitTimer.start(static_cast<int>(waitMs));
+        break;
+      }
+      lastRequestTimeMs.insert(host, now);
+    }
 
-    loadMetar(metarRequests.last());
+    // Newest request first since this is most likely the one the user is waiting for
+    loadMetar(metarRequests.takeLast());
   }
 }
 
@@ -168,16 +222,17 @@ void WeatherNetSingle::indexDownloadFinished(const QByteArray& data, QString dow
   emit weatherUpdated();
 }
 
-void WeatherNetSingle::cancelReply()
+void WeatherNetSingle::cancelReplies()
 {
-  if(replyMetar != nullptr)
+  for(auto it = metarReplies.constBegin(); it != metarReplies.constEnd(); ++it)
   {
-    disconnect(replyMetar, &QNetworkReply::finished, this, &WeatherNetSingle::httpFinishedMetar);
-    replyMetar->abort();
-    replyMetar->deleteLater();
-    replyMetar = nullptr;
-    metarRequestIcao.clear();
+    QNetworkReply *reply = it.key();
+    disconnect(reply, &QNetworkReply::finished, this, nullptr);
+    reply->abort();
+    reply->deleteLater();
   }
+  metarReplies.clear();
+  metarReplyIcaos.clear();
 }
 
 void WeatherNetSingle::loadMetar(const QString& airportIcao)
@@ -190,73 +245,66 @@ void WeatherNetSingle::loadMetar(const QString& airportIcao)
   // VATSIM
   // http://metar.vatsim.net/metar.php?id=EDDF
 
-  if(replyMetar != nullptr)
-  {
-    if(!metarRequests.contains(airportIcao))
-    {
-      if(verbose)
-        qDebug() << Q_FUNC_INFO << airportIcao;
-      metarRequests.append(airportIcao);
-    }
-  }
-  else
-  {
-    if(verbose)
-      qDebug() << Q_FUNC_INFO << "Building METAR request" << airportIcao << requestUrl;
-    cancelReply();
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "Building METAR request" << airportIcao << requestUrl;
 
-    metarRequestIcao = airportIcao;
-    QNetworkRequest request(QUrl(requestUrl.arg(airportIcao)));
+  QNetworkRequest request(QUrl(requestUrl.arg(airportIcao)));
 
-    replyMetar = networkManager.get(request);
+  QNetworkReply *reply = networkManager.get(request);
 
-    if(replyMetar != nullptr)
-      connect(replyMetar, &QNetworkReply::finished, this, &WeatherNetSingle::httpFinishedMetar);
-    else
-      qWarning() << "METAR Reply is null";
+  if(reply != nullptr)
+  {
+    metarReplies.insert(reply, airportIcao);
+    metarReplyIcaos.insert(airportIcao);
+    connect(reply, &QNetworkReply::finished, this, [ = ]() -> void
+          {
+            httpFinishedMetar(reply);
+          });
   }
+  else
+    qWarning() << "METAR Reply is null";
 }
 
 /* Called by network reply signal */
-void WeatherNetSingle::httpFinishedMetar()
+void WeatherNetSingle::httpFinishedMetar(QNetworkReply *reply)
 {
+  QString icao = metarReplies.take(reply);
+  metarReplyIcaos.remove(icao);
+
   if(verbose)
-    qDebug() << Q_FUNC_INFO << metarRequestIcao;
+    qDebug() << Q_FUNC_INFO << icao;
 
-  metarRequests.removeAll(metarRequestIcao);
-  httpFinished(metarRequestIcao);
-  replyMetar = nullptr;
+  httpFinished(reply, icao);
 
-  if(!metarRequests.isEmpty())
-    loadMetar(metarRequests.last());
+  // Send next requests from queue
+  flushRequestQueue();
 }
 
-void WeatherNetSingle::httpFinished(const QString& icao)
+void WeatherNetSingle::httpFinished(QNetworkReply *reply, const QString& icao)
 {
-  if(replyMetar != nullptr)
+  if(reply->error() == QNetworkReply::NoError)
   {
-    if(replyMetar->error() == QNetworkReply::NoError)
+    QString metar = reply->readAll().simplified();
+    if(!metar.contains("no metar available", Qt::CaseInsensitive))
     {
-      QString metar = replyMetar->readAll().simplified();
-      if(!metar.contains("no metar available", Qt::CaseInsensitive))
-        // Add metar with current time
-        metarCache.insert(icao, metar);
-      else
-        // Add empty record so we know there is no weather station
-        metarCache.insert(icao, QString());
-      // mainWindow->setStatusMessage(tr("Weather information updated."));
-      emit weatherUpdated();
+      // Add metar with current time
+      metarCache.insert(icao, metar);
+      noMetarCache.remove(icao);
     }
-    else if(replyMetar->error() != QNetworkReply::OperationCanceledError)
-    {
-      metarCache.insert(icao, QString());
-      if(replyMetar->error() != QNetworkReply::ContentNotFoundError)
-        qWarning() << "Request for" << icao << "failed. Reason:" << replyMetar->errorString();
-    }
-    replyMetar->abort();
-    replyMetar->disconnect(replyMetar, &QNetworkReply::finished, this, &WeatherNetSingle::httpFinishedMetar);
-    replyMetar->deleteLater();
+    else
+      // Add record so we know there is no weather station
+      noMetarCache.insert(icao, true);
+    // mainWindow->setStatusMessage(tr("Weather information updated."));
+    emit weatherUpdated();
+  }
+  else if(reply->error() != QNetworkReply::OperationCanceledError)
+  {
+    noMetarCache.insert(icao, true);
+    if(reply->error() != QNetworkReply::ContentNotFoundError)
+      qWarning() << "Request for" << icao << "failed. Reason:" << reply->errorString();
   }
+  disconnect(reply, &QNetworkReply::finished, this, nullptr);
+  reply->deleteLater();
 }
 
 } // namespace weather
@@ -22,10 +22,13 @@
 #include "geo/simplespatialindex.h"
 
 #include <QHash>
+#include <QSet>
 #include <QNetworkAccessManager>
 #include <QObject>
 #include <QTimer>
 
+#include <algorithm>
+
 namespace atools {
 namespace util {
 class HttpDownloader;
@@ -44,8 +47,11 @@ struct MetarResult;
  * that deliver one weather report per request.
  *
  * Uses hashmaps to cache online requests. Cache entries will timeout after 15 minutes.
+ * Answers without a report and failed requests are cached separately with their own timeout.
  *
- * Only one request is done. If a request is already waiting a new one will cancel the old one.
+ * Requests are queued and sent in parallel up to a maximum number. Duplicate requests for the same airport
+ * are coalesced and the newest request is sent first. Requests to the same host can be limited by
+ * a minimum interval.
  */
 class WeatherNetSingle :
   public QObject
@@ -64,6 +70,29 @@ public:
    */
   atools::fs::weather::MetarResult getMetar(const QString& airportIcao, const atools::geo::Pos& pos);
 
+  /* Queue requests for all airports which are neither cached nor already requested. Requests are sent
+   * after all interactive requests from getMetar() in the given order. Used to load weather for a whole route.
+   * Signal weatherUpdated is emitted for each fulfilled request. */
+  void prefetchMetars(const QStringList& airportIcaos);
+
+  /* Maximum number of requests running in parallel. Default is 4. */
+  void setMaxParallelRequests(int value)
+  {
+    maxParallelRequests = std::max(value, 1);
+  }
+
+  /* Minimum time between starting two requests to the same host. 0 disables the limit which is the default. */
+  void setMinRequestIntervalMs(int value)
+  {
+    minRequestIntervalMs = value;
+  }
+
+  /* Timeout for cached answers without report and for failed requests. Default is the same as for reports. */
+  void setNoMetarTimeoutSeconds(int value)
+  {
+    noMetarCache = atools::util::TimedCache<QString, bool>(value);
+  }
+
   /* Set request URL. %1 is ICAO placeholder */
   void setRequestUrl(const QString& url)
   {
@@ -90,12 +119,15 @@ signals:
 private:
   void loadMetar(const QString& airportIcao);
 
-  void httpFinished(const QString& icao);
-  void httpFinishedMetar();
+  void httpFinished(QNetworkReply *reply, const QString& icao);
+  void httpFinishedMetar(QNetworkReply *reply);
 
-  void cancelReply();
+  void cancelReplies();
   void flushRequestQueue();
 
+  /* true if airport is not cached, not in queue and not requested */
+  bool isRequestNeeded(const QString& airportIcao);
+
   void loadIndex();
   void indexDownloadFinished(const QByteArray& data, QString downloadUrl);
 
@@ -103,16 +135,24 @@ private:
 
   atools::util::TimedCache<QString, QString> metarCache;
 
+  /* Airports without report or with failed requests. Value is not used. */
+  atools::util::TimedCache<QString, bool> noMetarCache;
+
   QNetworkAccessManager networkManager;
 
-  // Stores the request ICAO so we can send it to httpFinished()
-  QString metarRequestIcao;
+  // Running replies and the requested ICAO
+  QHash<QNetworkReply *, QString> metarReplies;
+  QSet<QString> metarReplyIcaos;
 
-  // Keeps the reply
-  QNetworkReply *replyMetar = nullptr;
+  // Queue of waiting requests. Last is sent first.
   QStringList metarRequests;
 
-  QTimer flushQueueTimer;
+  // Start time of the last request per host in ms since epoch
+  QHash<QString, qint64> lastRequestTimeMs;
+
+  int maxParallelRequests = 4, minRequestIntervalMs = 0;
+
+  QTimer flushQueueTimer, rateLimitTimer;
   QString requestUrl, stationIndexUrl;
   std::function<void(QString& icao, QDateTime& lastUpdate, const QString& line)> indexParseFunction = nullptr;
   QSet<QString> stationIndex;
@@ -1394,9 +1394,9 @@ void XpAirportWriter::bindAirport(const QStringList& line, AirportRowCode rowCod
       // Remove [H], [S], [g] and [mil] indicators
       name = name.replace(NAME_INDICATOR, "").trimmed();
 
-    // Check military before converting to caps
-    bool isMil = atools::fs::util::isNameMilitary(name);
-    name = atools::fs::util::capAirportName(name);
+    // Check military and convert to caps in one pass - closed indicator was already checked above
+    bool isMil, closedDummy;
+    name = atools::fs::util::capAirportName(name, isMil, closedDummy);
 
     insertAirportQuery->bindValue(":ident", airportIdent);
     insertAirportQuery->bindValue(":name", name);
@@ -562,6 +562,8 @@ void XpDataCompiler::close()
   delete airwayPostProcess;
   airwayPostProcess = nullptr;
 
+  if(airportIndex != nullptr)
+    qDebug() << Q_FUNC_INFO << "Airport index memory" << airportIndex->memorySize() << "bytes";
   delete airportIndex;
   airportIndex = nullptr;
 
@@ -578,6 +580,8 @@ QStringList XpDataCompiler::findCustomAptDatFiles(const atools::fs::NavDatabaseO
                                                   atools::fs::NavDatabaseErrors *navdatabaseErrors,
                                                   atools::fs::ProgressHandler *progressHandler)
 {
+  // Cache directory listings while resolving file names
+  atools::PathNoCaseCacheScope cacheScope;
   QStringList retval;
 
   if(!opts.isReadInactive())
@@ -659,6 +663,7 @@ QStringList XpDataCompiler::findFiles(const NavDatabaseOptions& opts, const QStr
 
 int XpDataCompiler::calculateReportCount(const NavDatabaseOptions& opts)
 {
+  atools::PathNoCaseCacheScope cacheScope;
   int reportCount = 0;
   // Default or custom scenery files
   // earth_fix.dat earth_awy.dat earth_nav.dat
@@ -0,0 +1,209 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "geo/greatcircledensifier.h"
+
+#include "geo/calculations.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace atools {
+namespace geo {
+
+/* Stop bisection at this depth which limits a segment to 4096 points */
+static const int MAX_DEPTH = 12;
+
+/* Segments longer than this are always split - about 9 degree of arc */
+static const float MAX_SEGMENT_LENGTH_METER = 1000000.f;
+
+/* Minimum and maximum number of circle segments */
+static const int MIN_CIRCLE_SEGMENTS = 8;
+static const int MAX_CIRCLE_SEGMENTS = 720;
+
+/* Smallest tolerance level to avoid excessive point counts - 2^-2 = 0.25 meter */
+static const int MIN_TOLERANCE_LEVEL = -2;
+
+uint qHash(const GreatCircleDensifier::CacheKey& key)
+{
+  return qHashBits(&key, sizeof(GreatCircleDensifier::CacheKey));
+}
+
+bool GreatCircleDensifier::CacheKey::operator==(const CacheKey& other) const
+{
+  // Compare bits to be consistent with hash
+  return memcmp(this, &other, sizeof(CacheKey)) == 0;
+}
+
+GreatCircleDensifier::GreatCircleDensifier(int maxCachedPositions)
+  : cache(maxCachedPositions)
+{
+
+}
+
+void GreatCircleDensifier::clear()
+{
+  cache.clear();
+}
+
+int GreatCircleDensifier::toleranceLevel(float toleranceMeter)
+{
+  if(!(toleranceMeter > 0.f))
+    return MIN_TOLERANCE_LEVEL;
+
+  return std::max(static_cast<int>(std::floor(std::log2(toleranceMeter))), MIN_TOLERANCE_LEVEL);
+}
+
+LineString GreatCircleDensifier::densify(const Pos& pos1, const Pos& pos2, float toleranceMeter)
+{
+  int level = toleranceLevel(toleranceMeter);
+  CacheKey key = {pos1.getLonX(), pos1.getLatY(), pos2.getLonX(), pos2.getLatY(), 0.f, level};
+
+  LineString retval;
+  LineString *line = cache.object(key);
+  if(line != nullptr)
+    retval = *line;
+  else
+  {
+    line = new LineString(densifyLine(pos1, pos2, std::ldexp(1.f, level)));
+    retval = *line;
+    cache.insert(key, line, line->size());
+  }
+
+  // Key does not contain altitude - apply altitudes of this call like densifyLine()
+  for(int i = 0; i < retval.size() - 1; i++)
+    retval[i].setAltitude(pos1.getAltitude());
+  retval.last().setAltitude(pos2.getAltitude());
+  return retval;
+}
+
+LineString GreatCircleDensifier::densify(const LineString& line, float toleranceMeter)
+{
+  LineString retval;
+  if(line.size() < 2)
+    return line;
+
+  retval.append(line.first());
+  for(int i = 0; i < line.size() - 1; i++)
+  {
+    // Omit the first point which is already added with the last segment
+    LineString segment = densify(line.at(i), line.at(i + 1), toleranceMeter);
+    retval.append(segment.mid(1));
+  }
+  return retval;
+}
+
+LineString GreatCircleDensifier::circle(const Pos& origin, float radiusMeter, float toleranceMeter)
+{
+  int level = toleranceLevel(toleranceMeter);
+  CacheKey key = {origin.getLonX(), origin.getLatY(), 0.f, 0.f, radiusMeter, level};
+
+  LineString *line = cache.object(key);
+  if(line != nullptr)
+    return *line;
+
+  line = new LineString(densifyCircle(origin, radiusMeter, std::ldexp(1.f, level)));
+  LineString retval = *line;
+  cache.insert(key, line, line->size());
+  return retval;
+}
+
+LineString GreatCircleDensifier::densifyLine(const Pos& pos1, const Pos& pos2, float toleranceMeter)
+{
+  LineString line;
+  line.append(pos1);
+  if(pos1.isValid() && pos2.isValid() && pos1 != pos2)
+    densifySegment(line, pos1, pos2, toleranceMeter, 0);
+  line.append(pos2);
+  return line;
+}
+
+float GreatCircleDensifier::maxDeviationMeter(const Pos& pos1, const Pos& pos2, float distanceMeter)
+{
+  // Straight line between both in lon/lat space - take the shorter way across the anti-meridian
+  float lonx1 = pos1.getLonX(), lonx2 = pos2.getLonX();
+  if(lonx2 - lonx1 > 180.f)
+    lonx2 -= 360.f;
+  else if(lonx1 - lonx2 > 180.f)
+    lonx2 += 360.f;
+
+  // Sample more than the midpoint since legs symmetric around an inflection point like
+  // (-60,-30) to (60,30) have equal midpoints on chord and great circle
+  float deviation = 0.f;
+  for(float fraction : {0.25f, 0.5f, 0.75f})
+  {
+    Pos greatCircle = pos1.interpolate(pos2, distanceMeter, fraction);
+    if(!greatCircle.isValid() || std::isnan(greatCircle.getLonX()) || std::isnan(greatCircle.getLatY()))
+      // Antipodal points have no defined great circle
+      return 0.f;
+
+    Pos chord = Pos(lonx1 + (lonx2 - lonx1) * fraction,
+                    pos1.getLatY() + (pos2.getLatY() - pos1.getLatY()) * fraction).normalize();
+    deviation = std::max(deviation, greatCircle.distanceMeterTo(chord));
+  }
+  return deviation;
+}
+
+void GreatCircleDensifier::densifySegment(LineString& line, const Pos& pos1, const Pos& pos2,
+                                          float toleranceMeter, int depth)
+{
+  if(depth >= MAX_DEPTH)
+    return;
+
+  float distanceMeter = pos1.distanceMeterTo(pos2);
+
+  // Always split long segments since the samples can miss deviations
+  if(distanceMeter > MAX_SEGMENT_LENGTH_METER || maxDeviationMeter(pos1, pos2, distanceMeter) > toleranceMeter)
+  {
+    Pos mid = pos1.interpolate(pos2, distanceMeter, 0.5f);
+    if(!mid.isValid() || std::isnan(mid.getLonX()) || std::isnan(mid.getLatY()))
+      return;
+
+    mid.setAltitude(pos1.getAltitude());
+    densifySegment(line, pos1, mid, toleranceMeter, depth + 1);
+    line.append(mid);
+    densifySegment(line, mid, pos2, toleranceMeter, depth + 1);
+  }
+}
+
+LineString GreatCircleDensifier::densifyCircle(const Pos& origin, float radiusMeter, float toleranceMeter)
+{
+  LineString line;
+  if(!origin.isValid() || !(radiusMeter > 0.f))
+    return line;
+
+  // Sagitta of a chord for angle a: radius * (1 - cos(a / 2)) <= tolerance
+  int numSegments = MAX_CIRCLE_SEGMENTS;
+  if(toleranceMeter < radiusMeter)
+  {
+    double angleDeg = toDegree(2. * std::acos(1. - static_cast<double>(toleranceMeter) / radiusMeter));
+    if(angleDeg > 0.)
+      numSegments = static_cast<int>(std::ceil(360. / angleDeg));
+  }
+  else
+    numSegments = MIN_CIRCLE_SEGMENTS;
+  numSegments = std::max(std::min(numSegments, MAX_CIRCLE_SEGMENTS), MIN_CIRCLE_SEGMENTS);
+
+  line.reserve(numSegments);
+  for(int i = 0; i < numSegments; i++)
+    line.append(origin.endpoint(radiusMeter, 360.f * i / numSegments).normalize());
+  return line;
+}
+
+} // namespace geo
+} // namespace atools
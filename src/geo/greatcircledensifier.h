@@ -0,0 +1,101 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_GEO_GREATCIRCLEDENSIFIER_H
+#define ATOOLS_GEO_GREATCIRCLEDENSIFIER_H
+
+#include "geo/linestring.h"
+
+#include <QCache>
+
+namespace atools {
+namespace geo {
+
+/*
+ * Adds points to great circle lines and circles so that straight lines drawn between the points in
+ * longitude/latitude space do not deviate more than a tolerance from the true geometry.
+ *
+ * Lines are bisected recursively where the great circle is farther than the tolerance from the chord at
+ * one of the sample points at 1/4, 1/2 and 3/4 of the length. Segments longer than about 9 degree of arc
+ * are always split since samples can miss deviations. Short legs get no points and long oceanic legs
+ * as many as needed. Circle segments are calculated from radius and tolerance.
+ *
+ * Cases to check when changing the algorithm are lines crossing the equator symmetric to the inflection point
+ * like (-60,-30) to (60,30), lines crossing the anti-meridian, crossing the north pole like (0,80) to (180,80)
+ * and passing close to the south pole. No resulting segment may deviate more than the tolerance.
+ *
+ * Results are cached for each geometry and tolerance level. Tolerances are rounded down to the next power
+ * of two in meter which keeps the number of levels low while zooming. Cached lines do not depend on altitude.
+ * Points of densified lines get the altitude of pos1 except the last one which gets the altitude of pos2.
+ *
+ * Static methods are re-entrant. Cached methods are not thread safe.
+ */
+class GreatCircleDensifier
+{
+public:
+  /* maxCachedPositions is the total number of positions kept in the cache */
+  GreatCircleDensifier(int maxCachedPositions = 100000);
+
+  /* Get line from pos1 to pos2 including both. Cached. */
+  atools::geo::LineString densify(const atools::geo::Pos& pos1, const atools::geo::Pos& pos2,
+                                  float toleranceMeter);
+
+  /* Get densified line string. Each segment is cached. */
+  atools::geo::LineString densify(const atools::geo::LineString& line, float toleranceMeter);
+
+  /* Get circle with segments depending on radius and tolerance. First point is not repeated. Cached. */
+  atools::geo::LineString circle(const atools::geo::Pos& origin, float radiusMeter, float toleranceMeter);
+
+  void clear();
+
+  /* Line from pos1 to pos2 including both. Not cached. */
+  static atools::geo::LineString densifyLine(const atools::geo::Pos& pos1, const atools::geo::Pos& pos2,
+                                             float toleranceMeter);
+
+  /* Circle not cached */
+  static atools::geo::LineString densifyCircle(const atools::geo::Pos& origin, float radiusMeter,
+                                               float toleranceMeter);
+
+  /* Rounds tolerance down to a power of two and returns the exponent */
+  static int toleranceLevel(float toleranceMeter);
+
+private:
+  struct CacheKey
+  {
+    float lonx1, laty1, lonx2, laty2, radius;
+    int level;
+
+    bool operator==(const CacheKey& other) const;
+
+  };
+
+  friend uint qHash(const atools::geo::GreatCircleDensifier::CacheKey& key);
+
+  /* Largest distance between great circle and lon/lat chord at 1/4, 1/2 and 3/4 of the segment */
+  static float maxDeviationMeter(const atools::geo::Pos& pos1, const atools::geo::Pos& pos2, float distanceMeter);
+
+  /* Append all points between pos1 and pos2 excluding both */
+  static void densifySegment(atools::geo::LineString& line, const atools::geo::Pos& pos1,
+                             const atools::geo::Pos& pos2, float toleranceMeter, int depth);
+
+  QCache<CacheKey, atools::geo::LineString> cache;
+};
+
+} // namespace geo
+} // namespace atools
+
+#endif // ATOOLS_GEO_GREATCIRCLEDENSIFIER_H
@@ -22,7 +22,6 @@
 #include "atools.h"
 
 #include <QDataStream>
-#include <QRegularExpression>
 #include <QVector3D>
 
 namespace atools {
@@ -37,19 +36,339 @@ const static QString SHORT_FORMAT_ALT("%1,%2,%3");
 const static QString HUMAN_FORMAT("%6° %7' %8\"%5, %2° %3' %4\"%1");
 const static QString LONG_FORMAT("%1%2° %3' %4\",%5%6° %7' %8\",%9%10");
 
-// This is the format that is used in FSX flight plans
-// N49° 26' 41.57",E9° 12' 5.49",+005500.00
-const static QRegularExpression LONG_FORMAT_REGEXP(
-  "([ns])\\s*([0-9]+)\\s*°\\s*([0-9]+)\\s*'\\s*([0-9\\.]+)\\s*\"\\s*,\\s*"
-  "([ew])\\s*([0-9]+)\\s*°\\s*([0-9]+)\\s*'\\s*([0-9\\.]+)\\s*\"\\s*,\\s*"
-  "([+-]?)\\s*([0-9\\.]+)?");
+namespace {
 
-// Format as used in FS9 flight plans
-// N54* 16.82', W008* 35.95', +000011.00
-const static QRegularExpression LONG_FORMAT_OLD_REGEXP(
-  "([ns])\\s*([0-9]+)\\s*[\\*°]\\s*([0-9\\.]+)\\s*[']?\\s*'\\s*,\\s*"
-  "([ew])\\s*([0-9]+)\\s*[\\*°]\\s*([0-9\\.]+)\\s*[']?\\s*'\\s*,\\s*"
-  "([+-]?)\\s*([0-9\\.]+)?");
+/*
+ * Allocation free parser for the coordinate formats below. Accepts exactly the same input as the
+ * regular expressions noted in the comments, including unanchored matching, and converts the numbers
+ * like QString::toInt() and QString::toFloat() do.
+ */
+class PosParser
+{
+public:
+  PosParser(const QString& str)
+    : string(str), data(str.constData()), size(str.size())
+  {
+  }
+
+  /* true if string is empty or contains only whitespace */
+  bool isBlank() const
+  {
+    for(int i = 0; i < size; i++)
+    {
+      if(!data[i].isSpace())
+        return false;
+    }
+    return true;
+  }
+
+  /* This is the format that is used in FSX flight plans
+   * N49° 26' 41.57",E9° 12' 5.49",+005500.00
+   * ([ns])\s*([0-9]+)\s*°\s*([0-9]+)\s*'\s*([0-9\.]+)\s*"\s*,\s*
+   * ([ew])\s*([0-9]+)\s*°\s*([0-9]+)\s*'\s*([0-9\.]+)\s*"\s*,\s*
+   * ([+-]?)\s*([0-9\.]+)? */
+  bool parseLongFormat(float& lonX, float& latY, float& altitude)
+  {
+    for(int start = 0; start < size; start++)
+    {
+      pos = start;
+
+      bool south, west;
+      int latYDeg, latYMin, lonXDeg, lonXMin;
+      float latYSec, lonXSec, alt;
+      if(letter('n', 's', south) && integer(latYDeg) && token(DEGREE_SIGN) &&
+         integer(latYMin) && token('\'') && number(latYSec) && token('"') && token(',') &&
+         letterToken('e', 'w', west) && integer(lonXDeg) && token(DEGREE_SIGN) &&
+         integer(lonXMin) && token('\'') && number(lonXSec) && token('"') && token(',') &&
+         altitudeValue(alt))
+      {
+        latY = (latYDeg + latYMin / 60.f + latYSec / 3600.f) * (south ? -1.f : 1.f);
+        lonX = (lonXDeg + lonXMin / 60.f + lonXSec / 3600.f) * (west ? -1.f : 1.f);
+        altitude = alt;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /* Format as used in FS9 flight plans
+   * N54* 16.82', W008* 35.95', +000011.00
+   * ([ns])\s*([0-9]+)\s*[\*°]\s*([0-9\.]+)\s*[']?\s*'\s*,\s*
+   * ([ew])\s*([0-9]+)\s*[\*°]\s*([0-9\.]+)\s*[']?\s*'\s*,\s*
+   * ([+-]?)\s*([0-9\.]+)? */
+  bool parseLongFormatOld(float& lonX, float& latY, float& altitude)
+  {
+    for(int start = 0; start < size; start++)
+    {
+      pos = start;
+
+      bool south, west;
+      int latYDeg, lonXDeg;
+      float latYMin, lonXMin, alt;
+      if(letter('n', 's', south) && integer(latYDeg) && degreeOld() && number(latYMin) && minuteOld() &&
+         token(',') &&
+         letterToken('e', 'w', west) && integer(lonXDeg) && degreeOld() && number(lonXMin) && minuteOld() &&
+         token(',') &&
+         altitudeValue(alt))
+      {
+        latY = (latYDeg + latYMin / 60.f) * (south ? -1.f : 1.f);
+        lonX = (lonXDeg + lonXMin / 60.f) * (west ? -1.f : 1.f);
+        altitude = alt;
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  static Q_DECL_CONSTEXPR ushort DEGREE_SIGN = 0x00b0;
+
+  /* Same as \s in the regular expressions which do not use unicode properties */
+  static bool isSpace(ushort c)
+  {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+  }
+
+  static bool isDigit(ushort c)
+  {
+    return c >= '0' && c <= '9';
+  }
+
+  void skipSpace()
+  {
+    while(pos < size && isSpace(data[pos].unicode()))
+      pos++;
+  }
+
+  /* Skip whitespace and consume character */
+  bool token(ushort c)
+  {
+    skipSpace();
+    if(pos < size && data[pos].unicode() == c)
+    {
+      pos++;
+      return true;
+    }
+    return false;
+  }
+
+  /* Case insensitive match of one of two lowercase ASCII letters. Does not skip whitespace. */
+  bool letter(char first, char second, bool& isSecond)
+  {
+    if(pos < size)
+    {
+      ushort c = data[pos].unicode();
+      if(c >= 'A' && c <= 'Z')
+        c += 'a' - 'A';
+
+      if(c == first || c == second)
+      {
+        isSecond = c == second;
+        pos++;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /* Skip whitespace and match letter */
+  bool letterToken(char first, char second, bool& isSecond)
+  {
+    skipSpace();
+    return letter(first, second, isSecond);
+  }
+
+  /* [\*°] */
+  bool degreeOld()
+  {
+    skipSpace();
+    if(pos < size && (data[pos].unicode() == '*' || data[pos].unicode() == DEGREE_SIGN))
+    {
+      pos++;
+      return true;
+    }
+    return false;
+  }
+
+  /* [']?\s*' */
+  bool minuteOld()
+  {
+    if(!token('\''))
+      return false;
+
+    // Second optional quote
+    token('\'');
+    return true;
+  }
+
+  /* Skip whitespace and read [0-9]+. Value is 0 on overflow like QString::toInt(). */
+  bool integer(int& value)
+  {
+    skipSpace();
+    int start = pos;
+    qint64 result = 0;
+    while(pos < size && isDigit(data[pos].unicode()))
+    {
+      if(result <= std::numeric_limits<int>::max())
+        result = result * 10 + (data[pos].unicode() - '0');
+      pos++;
+    }
+
+    value = result <= std::numeric_limits<int>::max() ? static_cast<int>(result) : 0;
+    return pos > start;
+  }
+
+  /* Skip whitespace and read [0-9\.]+. valid is false if the text cannot be converted. */
+  bool number(float& value)
+  {
+    bool valid;
+    return number(value, valid);
+  }
+
+  bool number(float& value, bool& valid)
+  {
+    skipSpace();
+    int start = pos;
+    while(pos < size && (isDigit(data[pos].unicode()) || data[pos].unicode() == '.'))
+      pos++;
+
+    if(pos > start)
+    {
+      value = toFloat(start, pos - start, valid);
+      return true;
+    }
+    return false;
+  }
+
+  /* Skip whitespace and read ([+-]?)\s*([0-9\.]+)? which always matches */
+  bool altitudeValue(float& value)
+  {
+    skipSpace();
+    bool negative = false;
+    if(pos < size && (data[pos].unicode() == '+' || data[pos].unicode() == '-'))
+      negative = data[pos++].unicode() == '-';
+
+    float num;
+    bool valid;
+    if(number(num, valid) && valid)
+      value = negative ? -num : num;
+    else
+      // Sign only, nothing or invalid number - QString::toFloat() returns 0 on error
+      value = 0.f;
+    return true;
+  }
+
+  /* Convert like QString::toFloat() which returns 0 on error.
+   * Numbers with up to 15 digits are converted exactly by dividing by a power of ten. Others fall back to Qt. */
+  float toFloat(int start, int length, bool& valid) const
+  {
+    static const double POWERS_OF_TEN[] =
+    {1., 1.e1, 1.e2, 1.e3, 1.e4, 1.e5, 1.e6, 1.e7, 1.e8, 1.e9, 1.e10, 1.e11, 1.e12, 1.e13, 1.e14, 1.e15};
+
+    int numDigits = 0, numDecimals = 0, numDots = 0;
+    quint64 mantissa = 0;
+    for(int i = start; i < start + length; i++)
+    {
+      ushort c = data[i].unicode();
+      if(c == '.')
+        numDots++;
+      else
+      {
+        mantissa = mantissa * 10 + (c - '0');
+        numDigits++;
+        if(numDots > 0)
+          numDecimals++;
+      }
+
+      if(numDigits > 15)
+        // Too many digits for exact conversion
+        return QStringRef(&string, start, length).toFloat(&valid);
+    }
+
+    valid = numDots <= 1 && numDigits > 0;
+    if(!valid)
+      // Invalid number like "1.2.3" or "."
+      return 0.f;
+
+    // Both values are exact in double and IEEE division rounds correctly
+    return static_cast<float>(static_cast<double>(mantissa) / POWERS_OF_TEN[numDecimals]);
+  }
+
+  const QString& string;
+  const QChar *data;
+  int size, pos = 0;
+};
+
+/* Appends formatted numbers to a fixed buffer to avoid the temporary strings of QString::arg() */
+class PosFormatter
+{
+public:
+  void append(char c)
+  {
+    buffer[length++] = QLatin1Char(c);
+  }
+
+  void append(QChar c)
+  {
+    buffer[length++] = c;
+  }
+
+  /* Same as QString::arg(int) for positive values */
+  void appendInt(int value)
+  {
+    char digits[16];
+    int num = 0;
+    do
+    {
+      digits[num++] = static_cast<char>('0' + value % 10);
+      value /= 10;
+    } while(value > 0);
+
+    while(num > 0)
+      append(digits[--num]);
+  }
+
+  /* Same as QString::arg(value, width, 'f', 2, '0') for positive values.
+   * Returns false for large values or values too close to a rounding tie which have to be formatted by Qt. */
+  bool appendFixed2(double value, int width)
+  {
+    if(!(value < 1.e9))
+      return false;
+
+    double scaled = value * 100.;
+    double integral = std::floor(scaled);
+    double fraction = scaled - integral;
+    if(std::abs(fraction - 0.5) < 1.e-7)
+      return false;
+
+    qint64 cents = static_cast<qint64>(integral) + (fraction > 0.5 ? 1 : 0);
+    int integer = static_cast<int>(cents / 100), decimals = static_cast<int>(cents % 100);
+
+    int numDigits = 1;
+    for(int i = integer; i >= 10; i /= 10)
+      numDigits++;
+
+    for(int i = numDigits + 3; i < width; i++)
+      append('0');
+
+    appendInt(integer);
+    append('.');
+    append(static_cast<char>('0' + decimals / 10));
+    append(static_cast<char>('0' + decimals % 10));
+    return true;
+  }
+
+  QString toString() const
+  {
+    return QString(buffer, length);
+  }
+
+private:
+  QChar buffer[64];
+  int length = 0;
+};
+
+} // namespace
 
 using atools::absInt;
 
@@ -109,57 +428,14 @@ Pos::Pos(int lonXDeg, int lonXMin, float lonXSec, bool west,
 Pos::Pos(const QString& str, bool errorOnInvalid)
   : lonX(INVALID_VALUE), latY(INVALID_VALUE), altitude(0.f)
 {
-  QString coordStr(str.trimmed().toLower());
+  PosParser parser(str);
 
-  if(coordStr.trimmed().isEmpty() && errorOnInvalid)
+  if(parser.isBlank() && errorOnInvalid)
     throw Exception("Coordinate string is empty");
 
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP.match(coordStr);
-
-  if(match.hasMatch())
-  {
-    QString ns = match.captured(1);
-    int latYDeg = match.captured(2).toInt();
-    int latYMin = match.captured(3).toInt();
-    float latYSec = match.captured(4).toFloat();
-
-    QString ew = match.captured(5);
-    int lonXDeg = match.captured(6).toInt();
-    int lonXMin = match.captured(7).toInt();
-    float lonXSec = match.captured(8).toFloat();
-
-    QString altSign = match.captured(9);
-    QString altNum = match.captured(10);
-
-    altitude = QString(altSign + altNum).toFloat();
-
-    latY = (latYDeg + latYMin / 60.f + latYSec / 3600.f) * (ns == "s" ? -1.f : 1.f);
-    lonX = (lonXDeg + lonXMin / 60.f + lonXSec / 3600.f) * (ew == "w" ? -1.f : 1.f);
-  }
-  else
-  {
-    QRegularExpressionMatch matchOld = LONG_FORMAT_OLD_REGEXP.match(coordStr);
-    if(matchOld.hasMatch())
-    {
-      QString ns = matchOld.captured(1);
-      int latYDeg = matchOld.captured(2).toInt();
-      float latYMin = matchOld.captured(3).toFloat();
-
-      QString ew = matchOld.captured(4);
-      int lonXDeg = matchOld.captured(5).toInt();
-      float lonXMin = matchOld.captured(6).toFloat();
-
-      QString altSign = matchOld.captured(7);
-      QString altNum = matchOld.captured(8);
-
-      altitude = QString(altSign + altNum).toFloat();
-
-      latY = (latYDeg + latYMin / 60.f) * (ns == "s" ? -1.f : 1.f);
-      lonX = (lonXDeg + lonXMin / 60.f) * (ew == "w" ? -1.f : 1.f);
-    }
-    else if(errorOnInvalid)
-      throw Exception("Invalid lat/long format \"" + str + "\"");
-  }
+  if(!parser.parseLongFormat(lonX, latY, altitude) && !parser.parseLongFormatOld(lonX, latY, altitude) &&
+     errorOnInvalid)
+    throw Exception("Invalid lat/long format \"" + str + "\"");
 }
 
 bool Pos::operator==(const Pos& other) const
@@ -516,6 +792,37 @@ QString Pos::toLongString() const
   if(!isValid())
     throw Exception("Invalid position. Cannot convert to string");
 
+  // Fast path writing into a buffer - values below are the same as used in LONG_FORMAT
+  PosFormatter formatter;
+  formatter.append(latY > 0 ? 'N' : 'S');
+  formatter.appendInt(absInt(getLatYDeg()));
+  formatter.append(QChar(0x00b0));
+  formatter.append(' ');
+  formatter.appendInt(absInt(getLatYMin()));
+  formatter.append('\'');
+  formatter.append(' ');
+  if(formatter.appendFixed2(std::abs(getLatYSec()), 0))
+  {
+    formatter.append('"');
+    formatter.append(',');
+    formatter.append(lonX > 0 ? 'E' : 'W');
+    formatter.appendInt(absInt(getLonXDeg()));
+    formatter.append(QChar(0x00b0));
+    formatter.append(' ');
+    formatter.appendInt(absInt(getLonXMin()));
+    formatter.append('\'');
+    formatter.append(' ');
+    if(formatter.appendFixed2(std::abs(getLonXSec()), 0))
+    {
+      formatter.append('"');
+      formatter.append(',');
+      formatter.append(altitude >= 0 ? '+' : '-');
+      if(formatter.appendFixed2(std::abs(altitude), 9))
+        return formatter.toString();
+    }
+  }
+
+  // Rounding ties or large numbers
   return LONG_FORMAT.arg(latY > 0 ? "N" : "S").
          arg(absInt(getLatYDeg())).arg(absInt(getLatYMin())).arg(std::abs(getLatYSec()), 0, 'f', 2).
          arg(lonX > 0 ? "E" : "W").
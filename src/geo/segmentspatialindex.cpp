@@ -0,0 +1,493 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "geo/segmentspatialindex.h"
+#include "geo/calculations.h"
+
+#include <algorithm>
+#include <queue>
+
+namespace atools {
+namespace geo {
+namespace internal {
+
+namespace {
+
+/* Simple vector on the unit sphere */
+struct Vec3
+{
+  double x, y, z;
+
+  Vec3 operator+(const Vec3& o) const
+  {
+    return {x + o.x, y + o.y, z + o.z};
+  }
+
+  Vec3 operator-(const Vec3& o) const
+  {
+    return {x - o.x, y - o.y, z - o.z};
+  }
+
+  Vec3 operator*(double f) const
+  {
+    return {x * f, y * f, z * f};
+  }
+
+  double dot(const Vec3& o) const
+  {
+    return x * o.x + y * o.y + z * o.z;
+  }
+
+  Vec3 cross(const Vec3& o) const
+  {
+    return {y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x};
+  }
+
+  double length() const
+  {
+    return std::sqrt(x * x + y * y + z * z);
+  }
+
+  Vec3 normalized() const
+  {
+    double len = length();
+    return len > 0. ? Vec3{x / len, y / len, z / len} : Vec3{0., 0., 0.};
+  }
+
+  double coord(int axis) const
+  {
+    return axis == 0 ? x : (axis == 1 ? y : z);
+  }
+
+  /* Angle between two unit vectors in radians. Accurate also for small angles. */
+  double angle(const Vec3& o) const
+  {
+    return std::atan2(cross(o).length(), dot(o));
+  }
+
+  static Vec3 fromPos(const Pos& pos)
+  {
+    double lon = toRadians(static_cast<double>(pos.getLonX())), lat = toRadians(static_cast<double>(pos.getLatY()));
+    return {std::cos(lat) * std::cos(lon), std::cos(lat) * std::sin(lon), std::sin(lat)};
+  }
+
+};
+
+/* Segment geometry on the unit sphere */
+struct Segment
+{
+  Vec3 start, end,
+       normal, /* Normalized start x end. Points to the left of the course. */
+       center; /* Center of bounding sphere */
+  double length, /* Length in radians */
+         radius; /* Radius of bounding sphere in radians */
+  bool valid, point;
+};
+
+/* Bounding sphere tree node */
+struct Node
+{
+  Vec3 center;
+  double radius; /* radians */
+  int left = -1, right = -1; /* Child node indexes. -1 for leafs. */
+  int first = 0, count = 0; /* Range in segment index array for leafs */
+};
+
+} // namespace
+
+struct SegmentTree
+{
+  QVector<Segment> segments;
+  QVector<int> order; /* Segment indexes ordered by tree leafs */
+  QVector<Node> nodes;
+
+  constexpr static int MAX_LEAF_SIZE = 8;
+
+  int build(int first, int count);
+};
+
+int SegmentTree::build(int first, int count)
+{
+  Node node;
+
+  // Bounding sphere around the segment spheres
+  Vec3 sum{0., 0., 0.};
+  for(int i = first; i < first + count; i++)
+    sum = sum + segments.at(order.at(i)).center;
+
+  // Sum of unit vectors has at most length count - check before normalizing since the direction of a
+  // nearly cancelled sum is only numerical noise
+  if(sum.length() < count * 1.e-6)
+  {
+    // Segments are spread evenly around the sphere - no pruning possible
+    node.center = Vec3{0., 0., 1.};
+    node.radius = M_PI;
+  }
+  else
+  {
+    node.center = sum.normalized();
+    node.radius = 0.;
+    for(int i = first; i < first + count; i++)
+    {
+      const Segment& seg = segments.at(order.at(i));
+      node.radius = std::max(node.radius, node.center.angle(seg.center) + seg.radius);
+    }
+
+    // A sphere with a larger radius covers everything anyway
+    node.radius = std::min(node.radius, M_PI);
+  }
+
+  int nodeIndex = nodes.size();
+  nodes.append(node);
+
+  if(count <= MAX_LEAF_SIZE)
+  {
+    nodes[nodeIndex].first = first;
+    nodes[nodeIndex].count = count;
+  }
+  else
+  {
+    // Split at median of the axis with the largest extent
+    Vec3 minVec{1., 1., 1.}, maxVec{-1., -1., -1.};
+    for(int i = first; i < first + count; i++)
+    {
+      const Vec3& c = segments.at(order.at(i)).center;
+      minVec = {std::min(minVec.x, c.x), std::min(minVec.y, c.y), std::min(minVec.z, c.z)};
+      maxVec = {std::max(maxVec.x, c.x), std::max(maxVec.y, c.y), std::max(maxVec.z, c.z)};
+    }
+    Vec3 extent = maxVec - minVec;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+    int half = count / 2;
+    std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+                     [this, axis](int i1, int i2) -> bool {
+      return segments.at(i1).center.coord(axis) < segments.at(i2).center.coord(axis);
+    });
+
+    int left = build(first, half);
+    int right = build(first + half, count - half);
+    nodes[nodeIndex].left = left;
+    nodes[nodeIndex].right = right;
+  }
+  return nodeIndex;
+}
+
+/* Distance from point to segment in radians. Also calculates fraction and signed cross track distance. */
+static double pointToSegment(const Vec3& q, const Segment& seg, double& alongTrack, double& crossTrack,
+                             CrossTrackStatus& status)
+{
+  if(seg.point)
+  {
+    alongTrack = crossTrack = 0.;
+    status = ALONG_TRACK;
+    return q.angle(seg.start);
+  }
+
+  double sinCrossTrack = q.dot(seg.normal);
+  Vec3 projected = q - seg.normal * sinCrossTrack;
+
+  if(projected.length() > 1.e-12)
+  {
+    // Along track angle from start in direction of end
+    alongTrack = std::atan2(seg.start.cross(projected).dot(seg.normal), seg.start.dot(projected));
+    if(alongTrack >= 0. && alongTrack <= seg.length)
+    {
+      // Positive cross track means right of course
+      status = ALONG_TRACK;
+      crossTrack = -std::asin(std::max(-1., std::min(1., sinCrossTrack)));
+      return std::abs(crossTrack);
+    }
+  }
+  else
+    // Point is a pole of the great circle
+    alongTrack = 0.;
+
+  // Not abeam - use nearest end point
+  double distStart = q.angle(seg.start), distEnd = q.angle(seg.end);
+  if(distStart < distEnd)
+  {
+    status = BEFORE_START;
+    crossTrack = distStart;
+    return distStart;
+  }
+  else
+  {
+    status = AFTER_END;
+    crossTrack = distEnd;
+    return distEnd;
+  }
+}
+
+/* Point on the great circle of the segment within the segment range */
+static bool onSegment(const Vec3& p, const Segment& seg)
+{
+  return seg.start.cross(p).dot(seg.normal) >= 0. && p.cross(seg.end).dot(seg.normal) >= 0.;
+}
+
+/* Distance between two segments in radians. 0 if segments intersect. */
+static double segmentToSegment(const Segment& seg1, const Segment& seg2)
+{
+  if(!seg1.point && !seg2.point)
+  {
+    Vec3 intersect = seg1.normal.cross(seg2.normal);
+    if(intersect.length() > 1.e-12)
+    {
+      // Great circles intersect in two antipodal points
+      intersect = intersect.normalized();
+      if((onSegment(intersect, seg1) && onSegment(intersect, seg2)) ||
+         (onSegment(intersect * -1., seg1) && onSegment(intersect * -1., seg2)))
+        return 0.;
+    }
+  }
+
+  // Minimum distance of non intersecting arcs is at one of the end points
+  double along, cross;
+  CrossTrackStatus status;
+  double dist = pointToSegment(seg1.start, seg2, along, cross, status);
+  dist = std::min(dist, pointToSegment(seg1.end, seg2, along, cross, status));
+  dist = std::min(dist, pointToSegment(seg2.start, seg1, along, cross, status));
+  dist = std::min(dist, pointToSegment(seg2.end, seg1, along, cross, status));
+  return dist;
+}
+
+static Segment createSegment(const Line& line)
+{
+  Segment seg;
+  seg.valid = line.isValid();
+  if(seg.valid)
+  {
+    seg.start = Vec3::fromPos(line.getPos1());
+    seg.end = Vec3::fromPos(line.getPos2());
+    seg.length = seg.start.angle(seg.end);
+
+    Vec3 normal = seg.start.cross(seg.end);
+    seg.point = normal.length() < 1.e-12;
+    if(seg.point)
+    {
+      // Zero length or antipodal - treat as point at start
+      seg.normal = {0., 0., 0.};
+      seg.center = seg.start;
+      seg.radius = 0.;
+      seg.length = 0.;
+    }
+    else
+    {
+      seg.normal = normal.normalized();
+      seg.center = (seg.start + seg.end).normalized();
+      seg.radius = seg.length / 2.;
+    }
+  }
+  else
+  {
+    seg.start = seg.end = seg.normal = seg.center = {0., 0., 0.};
+    seg.length = seg.radius = 0.;
+    seg.point = false;
+  }
+  return seg;
+}
+
+static SegmentDistance createResult(int index, const Segment& seg, double dist, double alongTrack, double crossTrack,
+                                    CrossTrackStatus status)
+{
+  const double R = Pos::EARTH_RADIUS_METER;
+  SegmentDistance result;
+  result.index = index;
+  result.distanceMeter = static_cast<float>(dist * R);
+  result.lineDistance.status = status;
+  result.lineDistance.distance = static_cast<float>(crossTrack * R);
+  result.lineDistance.distanceFrom1 = static_cast<float>(alongTrack * R);
+  result.lineDistance.distanceFrom2 = static_cast<float>((seg.length - alongTrack) * R);
+
+  if(status == ALONG_TRACK)
+    result.fraction = seg.length > 0. ? static_cast<float>(alongTrack / seg.length) : 0.f;
+  else
+    result.fraction = status == BEFORE_START ? 0.f : 1.f;
+  return result;
+}
+
+/* Methods *************************************************************************************/
+
+void SegmentSpatialIndexPrivate::nearestSegments(QVector<SegmentDistance>& results, const Pos& pos, int number,
+                                                 float maxDistanceMeter) const
+{
+  results.clear();
+  if(p->nodes.isEmpty() || !pos.isValid() || number <= 0)
+    return;
+
+  Vec3 q = Vec3::fromPos(pos);
+  double maxDist = static_cast<double>(maxDistanceMeter) / Pos::EARTH_RADIUS_METER;
+
+  // Nodes sorted by lower bound distance - smallest first
+  typedef std::pair<double, int> Entry;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > nodeQueue;
+
+  // Found segments with largest distance on top
+  auto compare = [](const SegmentDistance& d1, const SegmentDistance& d2) -> bool {
+                   return d1.distanceMeter < d2.distanceMeter;
+                 };
+  std::priority_queue<SegmentDistance, std::vector<SegmentDistance>, decltype(compare)> found(compare);
+  double worstDist = maxDist;
+
+  nodeQueue.push(std::make_pair(0., 0));
+  while(!nodeQueue.empty())
+  {
+    Entry entry = nodeQueue.top();
+    nodeQueue.pop();
+
+    if(entry.first > worstDist)
+      // All remaining nodes are farther away
+      break;
+
+    const Node& node = p->nodes.at(entry.second);
+    if(node.left == -1)
+    {
+      for(int i = node.first; i < node.first + node.count; i++)
+      {
+        int index = p->order.at(i);
+        const Segment& seg = p->segments.at(index);
+        double along, cross;
+        CrossTrackStatus status;
+        double dist = pointToSegment(q, seg, along, cross, status);
+        if(dist <= worstDist)
+        {
+          found.push(createResult(index, seg, dist, along, cross, status));
+          if(static_cast<int>(found.size()) > number)
+            found.pop();
+
+          if(static_cast<int>(found.size()) == number)
+            worstDist = std::min(maxDist, static_cast<double>(found.top().distanceMeter) / Pos::EARTH_RADIUS_METER);
+        }
+      }
+    }
+    else
+    {
+      for(int child : {node.left, node.right})
+      {
+        const Node& childNode = p->nodes.at(child);
+        double lowerBound = std::max(0., q.angle(childNode.center) - childNode.radius);
+        if(lowerBound <= worstDist)
+          nodeQueue.push(std::make_pair(lowerBound, child));
+      }
+    }
+  }
+
+  results.resize(static_cast<int>(found.size()));
+  for(int i = results.size() - 1; i >= 0; i--)
+  {
+    results[i] = found.top();
+    found.pop();
+  }
+}
+
+void SegmentSpatialIndexPrivate::segmentsNearLine(QVector<int>& indexes, const Line& line, float distanceMeter) const
+{
+  if(p->nodes.isEmpty() || !line.isValid())
+    return;
+
+  Segment query = createSegment(line);
+  double maxDist = static_cast<double>(distanceMeter) / Pos::EARTH_RADIUS_METER;
+
+  QVector<int> stack({0});
+  while(!stack.isEmpty())
+  {
+    const Node& node = p->nodes.at(stack.takeLast());
+
+    // Distance from any point in the node sphere to the query segment is at least this
+    double along, cross;
+    CrossTrackStatus status;
+    if(pointToSegment(node.center, query, along, cross, status) - node.radius > maxDist)
+      continue;
+
+    if(node.left == -1)
+    {
+      for(int i = node.first; i < node.first + node.count; i++)
+      {
+        int index = p->order.at(i);
+        if(segmentToSegment(query, p->segments.at(index)) <= maxDist)
+          indexes.append(index);
+      }
+    }
+    else
+    {
+      stack.append(node.left);
+      stack.append(node.right);
+    }
+  }
+}
+
+SegmentDistance SegmentSpatialIndexPrivate::segmentDistance(int index, const Pos& pos) const
+{
+  const Segment& seg = p->segments.at(index);
+  if(!seg.valid || !pos.isValid())
+    return SegmentDistance();
+
+  double along, cross;
+  CrossTrackStatus status;
+  double dist = pointToSegment(Vec3::fromPos(pos), seg, along, cross, status);
+  return createResult(index, seg, dist, along, cross, status);
+}
+
+void SegmentSpatialIndexPrivate::reserve(int size)
+{
+  clear();
+  p->segments.resize(size);
+}
+
+void SegmentSpatialIndexPrivate::set(const Line& line, int index)
+{
+  p->segments[index] = createSegment(line);
+}
+
+void SegmentSpatialIndexPrivate::buildIndex()
+{
+  p->nodes.clear();
+  p->order.clear();
+
+  // Leave out invalid lines
+  for(int i = 0; i < p->segments.size(); i++)
+  {
+    if(p->segments.at(i).valid)
+      p->order.append(i);
+  }
+
+  if(!p->order.isEmpty())
+  {
+    p->nodes.reserve(p->order.size() / SegmentTree::MAX_LEAF_SIZE * 2 + 1);
+    p->build(0, p->order.size());
+  }
+}
+
+void SegmentSpatialIndexPrivate::clear()
+{
+  p->segments.clear();
+  p->order.clear();
+  p->nodes.clear();
+}
+
+SegmentSpatialIndexPrivate::SegmentSpatialIndexPrivate()
+{
+  p = new SegmentTree;
+}
+
+SegmentSpatialIndexPrivate::~SegmentSpatialIndexPrivate()
+{
+  delete p;
+}
+
+} // namespace internal
+} // namespace geo
+} // namespace atools
@@ -0,0 +1,216 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_GEO_SEGMENTSPATIALINDEX_H
+#define ATOOLS_GEO_SEGMENTSPATIALINDEX_H
+
+#include "geo/line.h"
+
+#include <QVector>
+#include <limits>
+
+namespace atools {
+namespace geo {
+
+template<typename T>
+class SegmentSpatialIndex;
+
+/* Result of a segment query. All distances in meter. */
+struct SegmentDistance
+{
+  int index = -1; /* Index of segment in the underlying vector */
+
+  /* Absolute distance to the segment used for ranking. Cross track distance if the position is abeam
+   * or distance to nearest end point otherwise. */
+  float distanceMeter = std::numeric_limits<float>::max();
+
+  /* Fraction of the projected position along the segment clamped to 0 (start) to 1 (end).
+   * Can be used with Line::interpolate() to get the nearest point. */
+  float fraction = 0.f;
+
+  /* Status, signed cross track distance and along track distances as in Line::distanceMeterToLine() */
+  atools::geo::LineDistance lineDistance;
+
+  bool isValid() const
+  {
+    return index != -1;
+  }
+
+};
+
+/* Get the line from index objects. Used by SegmentSpatialIndex which also accepts lines directly. */
+inline const atools::geo::Line& segmentIndexLine(const atools::geo::Line& line)
+{
+  return line;
+}
+
+template<typename T>
+atools::geo::Line segmentIndexLine(const T& type)
+{
+  return type.getLine();
+}
+
+/* Private parts *************************************************************************************/
+
+namespace internal {
+
+struct SegmentTree;
+
+/* Keeps the tree structures out of the template class. */
+class SegmentSpatialIndexPrivate
+{
+  template<typename T>
+  friend class atools::geo::SegmentSpatialIndex;
+
+  SegmentSpatialIndexPrivate();
+  ~SegmentSpatialIndexPrivate();
+
+  void nearestSegments(QVector<atools::geo::SegmentDistance>& results, const atools::geo::Pos& pos, int number,
+                       float maxDistanceMeter) const;
+  void segmentsNearLine(QVector<int>& indexes, const atools::geo::Line& line, float distanceMeter) const;
+  atools::geo::SegmentDistance segmentDistance(int index, const atools::geo::Pos& pos) const;
+
+  void reserve(int size);
+  void set(const atools::geo::Line& line, int index);
+  void buildIndex();
+  void clear();
+
+  SegmentTree *p = nullptr;
+};
+
+} // namespace internal
+/* End of private parts *************************************************************************************/
+
+/*
+ * Spatial index for great circle segments like airway segments, procedure legs or route legs.
+ *
+ * Segments are kept in a bounding sphere hierarchy on the unit sphere. Queries return the exact great circle
+ * cross track distance and the along track fraction for each segment. Segments crossing the anti-meridian
+ * or passing near the poles need no special handling.
+ *
+ * T has to provide a method "atools::geo::Line getLine() const" or has to be atools::geo::Line itself.
+ *
+ * Changing the underlying vector needs a call of updateIndex() afterwards.
+ */
+template<typename T>
+class SegmentSpatialIndex :
+  public QVector<T>
+{
+public:
+  SegmentSpatialIndex()
+  {
+    p = new atools::geo::internal::SegmentSpatialIndexPrivate;
+  }
+
+  ~SegmentSpatialIndex()
+  {
+    delete p;
+  }
+
+  SegmentSpatialIndex(const SegmentSpatialIndex& other) = delete;
+  SegmentSpatialIndex& operator=(const SegmentSpatialIndex& other) = delete;
+
+  /* Get the nearest segment to pos. Fills result if not null.
+   * Returns a default constructed object if index is empty. */
+  const T& getNearest(const atools::geo::Pos& pos, atools::geo::SegmentDistance *result = nullptr) const;
+
+  /* Get index of the nearest segment or -1 if nothing found */
+  int getNearestIndex(const atools::geo::Pos& pos, atools::geo::SegmentDistance *result = nullptr) const;
+
+  /* Get number nearest segments sorted by distance ascending.
+   * Only segments closer than maxDistanceMeter are returned. */
+  void getNearestIndexes(QVector<atools::geo::SegmentDistance>& results, const atools::geo::Pos& pos, int number,
+                         float maxDistanceMeter = std::numeric_limits<float>::max()) const
+  {
+    p->nearestSegments(results, pos, number, maxDistanceMeter);
+  }
+
+  /* Get all segments closer than radiusMeter sorted by distance ascending */
+  void getRadiusIndexes(QVector<atools::geo::SegmentDistance>& results, const atools::geo::Pos& pos,
+                        float radiusMeter) const
+  {
+    p->nearestSegments(results, pos, std::numeric_limits<int>::max(), radiusMeter);
+  }
+
+  /* Get all segments which come closer than distanceMeter to the given great circle line.
+   * Segments crossing the line are included. Order of indexes is undefined. */
+  void getNearLineIndexes(QVector<int>& indexes, const atools::geo::Line& line, float distanceMeter) const
+  {
+    p->segmentsNearLine(indexes, line, distanceMeter);
+  }
+
+  /* Exact distance from pos to the segment at index without using the tree */
+  atools::geo::SegmentDistance getDistance(int index, const atools::geo::Pos& pos) const
+  {
+    return p->segmentDistance(index, pos);
+  }
+
+  /* Rebuild the tree. Call this after changing the base class vector. */
+  void updateIndex();
+
+private:
+  atools::geo::internal::SegmentSpatialIndexPrivate *p = nullptr;
+};
+
+/* Methods *************************************************************************************/
+
+template<typename T>
+const T& SegmentSpatialIndex<T>::getNearest(const Pos& pos, SegmentDistance *result) const
+{
+  static const T EMPTY;
+  int idx = getNearestIndex(pos, result);
+  return idx >= 0 ? this->at(idx) : EMPTY;
+}
+
+template<typename T>
+int SegmentSpatialIndex<T>::getNearestIndex(const Pos& pos, SegmentDistance *result) const
+{
+  QVector<SegmentDistance> results;
+  p->nearestSegments(results, pos, 1, std::numeric_limits<float>::max());
+
+  if(!results.isEmpty())
+  {
+    if(result != nullptr)
+      *result = results.first();
+    return results.first().index;
+  }
+  else
+  {
+    if(result != nullptr)
+      *result = SegmentDistance();
+    return -1;
+  }
+}
+
+template<typename T>
+void SegmentSpatialIndex<T>::updateIndex()
+{
+  QVector<T>::squeeze();
+  p->reserve(QVector<T>::size());
+
+  for(int i = 0; i < QVector<T>::size(); i++)
+    p->set(segmentIndexLine(QVector<T>::at(i)), i);
+
+  p->buildIndex();
+}
+
+} // namespace geo
+} // namespace atools
+
+Q_DECLARE_TYPEINFO(atools::geo::SegmentDistance, Q_MOVABLE_TYPE);
+
+#endif // ATOOLS_GEO_SEGMENTSPATIALINDEX_H
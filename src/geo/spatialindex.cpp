@@ -20,6 +20,10 @@
 #include "geo/pos.h"
 #include "geo/calculations.h"
 
+#include <QHash>
+
+#include <limits>
+
 using namespace std;
 using namespace nanoflann;
 using atools::geo::Pos;
@@ -28,9 +32,54 @@ namespace atools {
 namespace geo {
 namespace internal {
 
+struct IndexEntry
+{
+  int index;
+  float distance;
+};
+
+/* Keeps the number nearest entries sorted by distance for filtered searches */
+class NearestResults
+{
+public:
+  NearestResults(int numberParam)
+    : number(numberParam)
+  {
+    result.reserve(number + 1);
+  }
+
+  void addPoint(float dist, int index)
+  {
+    // Insert sorted and drop the farthest if full
+    int pos = result.size();
+    while(pos > 0 && result.at(pos - 1).distance > dist)
+      pos--;
+    result.insert(pos, {index, dist});
+    if(result.size() > number)
+      result.removeLast();
+  }
+
+  float worstDist() const
+  {
+    return result.size() < number ? std::numeric_limits<float>::max() : result.last().distance;
+  }
+
+  const QVector<IndexEntry>& getResult() const
+  {
+    return result;
+  }
+
+private:
+  int number;
+  QVector<IndexEntry> result;
+};
+
 /* Private wrapper to keep nanoflann structures out of the header */
 struct DataSource
 {
+  typedef KDTreeSingleIndexAdaptor<L1_Adaptor<float, DataSource>, DataSource, 3, int> KdTree;
+  typedef KdTree::Node Node;
+
   DataSource()
     : index(DIMENSIONS, *this, KDTreeSingleIndexAdaptorParams(MAX_LEAF_SIZE))
   {
@@ -53,6 +102,78 @@ struct DataSource
     delete[] points;
     points = nullptr;
     pointsSize = 0;
+    masks.clear();
+    nodeMasks.clear();
+  }
+
+  /* Aggregate attribute masks of all objects below the node */
+  quint32 buildNodeMasks(const Node *node)
+  {
+    quint32 mask = 0;
+    if(node->child1 == nullptr && node->child2 == nullptr)
+    {
+      for(int i = node->node_type.lr.left; i < node->node_type.lr.right; i++)
+        mask |= masks.at(index.vind[static_cast<size_t>(i)]);
+    }
+    else
+      mask = buildNodeMasks(node->child1) | buildNodeMasks(node->child2);
+
+    nodeMasks.insert(node, mask);
+    return mask;
+  }
+
+  /* Same traversal as nanoflann searchLevel() but skipping subtrees not matching the required mask */
+  void searchFiltered(NearestResults& results, const float *pt, const Node *node, float minDist, float *dists,
+                      quint32 requiredMask, const IndexCallbackType& callback) const
+  {
+    if(requiredMask != 0 && (nodeMasks.value(node) & requiredMask) != requiredMask)
+      return;
+
+    if(node->child1 == nullptr && node->child2 == nullptr)
+    {
+      for(int i = node->node_type.lr.left; i < node->node_type.lr.right; i++)
+      {
+        int idx = index.vind[static_cast<size_t>(i)];
+        if(requiredMask != 0 && (masks.at(idx) & requiredMask) != requiredMask)
+          continue;
+
+        const Point3D& point = points[idx];
+        float dist = std::abs(pt[0] - point.getX()) + std::abs(pt[1] - point.getY()) +
+                     std::abs(pt[2] - point.getZ());
+        if(dist < results.worstDist() && (!callback || callback(idx)))
+          results.addPoint(dist, idx);
+      }
+      return;
+    }
+
+    // Which child branch should be taken first?
+    int feat = node->node_type.sub.divfeat;
+    float val = pt[feat];
+    float diff1 = val - node->node_type.sub.divlow, diff2 = val - node->node_type.sub.divhigh;
+
+    const Node *bestChild, *otherChild;
+    float cutDist;
+    if((diff1 + diff2) < 0.f)
+    {
+      bestChild = node->child1;
+      otherChild = node->child2;
+      cutDist = std::abs(val - node->node_type.sub.divhigh);
+    }
+    else
+    {
+      bestChild = node->child2;
+      otherChild = node->child1;
+      cutDist = std::abs(val - node->node_type.sub.divlow);
+    }
+
+    searchFiltered(results, pt, bestChild, minDist, dists, requiredMask, callback);
+
+    float dst = dists[feat];
+    minDist = minDist + cutDist - dst;
+    dists[feat] = cutDist;
+    if(minDist <= results.worstDist())
+      searchFiltered(results, pt, otherChild, minDist, dists, requiredMask, callback);
+    dists[feat] = dst;
   }
 
   // Must return the number of data points
@@ -88,7 +209,11 @@ struct DataSource
 
   int pointsSize = 0;
   Point3D *points = nullptr; // Must be initialized before the index
-  KDTreeSingleIndexAdaptor<L1_Adaptor<float, DataSource>, DataSource, DIMENSIONS, int> index;
+  KdTree index;
+
+  /* Attribute mask for each object and aggregated masks for each tree node. Empty if not used. */
+  QVector<quint32> masks;
+  QHash<const Node *, quint32> nodeMasks;
 };
 
 /* Methods *************************************************************************************/
@@ -117,12 +242,6 @@ void SpatialIndexPrivate::nearestPoints(QVector<int>& indexes, const Pos& pos, i
   indexes.resize(static_cast<int>(numFound));
 }
 
-struct IndexEntry
-{
-  int index;
-  float distance;
-};
-
 /* Callback for radius searches. Does min and max distance comparison. All distances in meter. */
 class RadiusResults
 {
@@ -187,9 +306,45 @@ void SpatialIndexPrivate::pointsInRadius(QVector<int>& indexes, const Pos& origi
     indexes.append(indicesDists.at(i).index);
 }
 
+void SpatialIndexPrivate::nearestPointsFiltered(QVector<int>& indexes, const Pos& pos, int number,
+                                                quint32 requiredMask, const IndexCallbackType& callback) const
+{
+  indexes.clear();
+  if(p->pointsSize == 0 || number <= 0 || p->index.root_node == nullptr)
+    return;
+
+  if(p->nodeMasks.isEmpty() && requiredMask != 0)
+    // No masks given - nothing can match
+    return;
+
+  float pt[3];
+  pos.toCartesian(pt[0], pt[1], pt[2]);
+
+  // Initial distances to the bounding box of all points
+  float dists[3] = {0.f, 0.f, 0.f}, minDist = 0.f;
+  for(int i = 0; i < 3; i++)
+  {
+    if(pt[i] < p->index.root_bbox[i].low)
+      dists[i] = p->index.root_bbox[i].low - pt[i];
+    else if(pt[i] > p->index.root_bbox[i].high)
+      dists[i] = pt[i] - p->index.root_bbox[i].high;
+    minDist += dists[i];
+  }
+
+  NearestResults results(number);
+  p->searchFiltered(results, pt, p->index.root_node, minDist, dists, requiredMask, callback);
+
+  for(const IndexEntry& entry : results.getResult())
+    indexes.append(entry.index);
+}
+
 void SpatialIndexPrivate::buildIndex()
 {
   p->index.buildIndex();
+
+  p->nodeMasks.clear();
+  if(!p->masks.isEmpty() && p->index.root_node != nullptr)
+    p->buildNodeMasks(p->index.root_node);
 }
 
 void SpatialIndexPrivate::set(const Point3D& point, int index)
@@ -197,6 +352,13 @@ void SpatialIndexPrivate::set(const Point3D& point, int index)
   p->points[index] = point;
 }
 
+void SpatialIndexPrivate::setMask(quint32 mask, int index)
+{
+  if(p->masks.size() != p->pointsSize)
+    p->masks.fill(0, p->pointsSize);
+  p->masks[index] = mask;
+}
+
 void SpatialIndexPrivate::clear()
 {
   p->free();
@@ -35,6 +35,10 @@ class SpatialIndex;
  * after filtering by manhattan distance to origin. */
 typedef std::function<bool (float, int)> RadiusCallbackType;
 
+/* A callback that is used as a secondary filter stage for filtered nearest searches.
+ * Called with the object index after the attribute mask matched. */
+typedef std::function<bool (int)> IndexCallbackType;
+
 /* Private parts *************************************************************************************/
 
 namespace internal {
@@ -54,7 +58,10 @@ class SpatialIndexPrivate
   void nearestPoints(QVector<int>& indexes, const atools::geo::Pos& pos, int number) const;
   void pointsInRadius(QVector<int>& indexes, const atools::geo::Pos& origin, float radiusMaxMeter,
                       const RadiusCallbackType& callback) const;
+  void nearestPointsFiltered(QVector<int>& indexes, const atools::geo::Pos& pos, int number, quint32 requiredMask,
+                             const IndexCallbackType& callback) const;
   void set(const Point3D& point, int index);
+  void setMask(quint32 mask, int index);
   void buildIndex();
   void clear();
   void reserve(int size);
@@ -109,6 +116,19 @@ public:
     p->nearestPoints(indexes, pos, number);
   }
 
+  /* Get number nearest objects or indexes having all bits of requiredMask set in their attribute mask.
+   * Needs attribute masks given in updateIndex(). The optional callback is evaluated only for objects matching
+   * the mask. Subtrees not containing any matching object are skipped during traversal which keeps the cost
+   * close to an unfiltered search even for selective filters. */
+  void getNearest(QVector<T>& objects, const atools::geo::Pos& pos, int number, quint32 requiredMask,
+                  const IndexCallbackType& callback = IndexCallbackType()) const;
+
+  void getNearestIndexes(QVector<int>& indexes, const atools::geo::Pos& pos, int number, quint32 requiredMask,
+                         const IndexCallbackType& callback = IndexCallbackType()) const
+  {
+    p->nearestPointsFiltered(indexes, pos, number, requiredMask, callback);
+  }
+
   /* Get all nearest objects or indexes from the vector fulfilling criteria.
    *  radiusMeter: Maximum distance from position. Measured using squared distance and therefore not accurate.
    */
@@ -131,6 +151,10 @@ public:
   /* Rebuild the KD-tree and Point3D vector. Call this after changing the base class vector. */
   void updateIndex();
 
+  /* As above and additionally store an attribute bitmask for each object which is used for filtered
+   * nearest searches. attributeMask is called once for each object. */
+  void updateIndex(const std::function<quint32(const T&)>& attributeMask);
+
   /* Get points converted to 3D euclidian space from base vector.
    * Size is the same as in the underlying parent QVector. */
   const Point3D *getPoints3D() const
@@ -180,6 +204,15 @@ void SpatialIndex<T>::getNearest(QVector<T>& objects, const Pos& pos, int number
   copyData(objects, indexes);
 }
 
+template<typename T>
+void SpatialIndex<T>::getNearest(QVector<T>& objects, const Pos& pos, int number, quint32 requiredMask,
+                                 const IndexCallbackType& callback) const
+{
+  QVector<int> indexes;
+  p->nearestPointsFiltered(indexes, pos, number, requiredMask, callback);
+  copyData(objects, indexes);
+}
+
 template<typename T>
 void SpatialIndex<T>::getRadius(QVector<T>& objects, const Pos& pos, float radiusMaxMeter,
                                 const RadiusCallbackType& callback) const
@@ -209,6 +242,21 @@ void SpatialIndex<T>::updateIndex()
   p->buildIndex();
 }
 
+template<typename T>
+void SpatialIndex<T>::updateIndex(const std::function<quint32(const T&)>& attributeMask)
+{
+  QVector<T>::squeeze();
+  p->reserve(QVector<T>::size());
+
+  for(int i = 0; i < QVector<T>::size(); i++)
+  {
+    p->set(QVector<T>::at(i).getPosition().toCartesian(), i);
+    p->setMask(attributeMask(QVector<T>::at(i)), i);
+  }
+
+  p->buildIndex();
+}
+
 } // namespace geo
 } // namespace atools
 
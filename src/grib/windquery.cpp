@@ -254,15 +254,46 @@ void WindQuery::initFromFixedModel(float dirLower, float speedLower, float altit
   altLayer.winds.fill(WindData{windUComponent(speedUpper, dirUpper),
                                windVComponent(speedUpper, dirUpper)}, 360 * 181);
   windLayers.insert(atools::roundToInt(altLayer.altitude), altLayer);
+  layersChanged();
 }
 
 void WindQuery::deinit()
 {
   windLayers.clear();
+  layersChanged();
   downloader->stopDownload();
   fileWatcher->stopWatching();
 }
 
+float WindQuery::getMaxWindSpeed(float altFeet) const
+{
+  if(maxWindSpeeds.isEmpty())
+    return 0.f;
+
+  // Interpolated U/V components are never larger than the larger of the two layers
+  QMap<int, float>::const_iterator it = maxWindSpeeds.lowerBound(atools::roundToInt(altFeet));
+  if(it == maxWindSpeeds.constEnd())
+    return maxWindSpeeds.last();
+  else if(it == maxWindSpeeds.constBegin())
+    // Below first layer is interpolated towards zero wind
+    return it.value();
+  else
+    return std::max(it.value(), (it - 1).value());
+}
+
+void WindQuery::layersChanged()
+{
+  maxWindSpeeds.clear();
+  for(const WindAltLayer& layer : windLayers)
+  {
+    float maxSpeed = 0.f;
+    for(const WindData& wind : layer.winds)
+      maxSpeed = std::max(maxSpeed, windSpeedFromUV(wind.u, wind.v));
+    maxWindSpeeds.insert(layer.altitude, maxSpeed);
+  }
+  dataVersion++;
+}
+
 Wind WindQuery::getWindForPos(const Pos& pos, bool interpolateValue) const
 {
   if(!pos.isValid())
@@ -641,6 +672,7 @@ void WindQuery::convertDataset(const GribDatasetVector& datasets)
     else
       throw atools::Exception("Invalid dataset order for  U and V wind component");
   }
+  layersChanged();
 }
 
 /* Interpolate wind speed and direction between two altitude layers */
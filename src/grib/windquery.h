@@ -198,6 +198,16 @@ public:
     return !windLayers.isEmpty();
   }
 
+  /* Upper bound for the wind speed in knots at the given altitude in feet anywhere on the grid.
+   * Can be used for admissible estimates in route calculation. */
+  float getMaxWindSpeed(float altFeet) const;
+
+  /* Incremented each time wind data is loaded, updated or cleared. Allows users to invalidate cached values. */
+  quint32 getDataVersion() const
+  {
+    return dataVersion;
+  }
+
   /* Samples per degree for wind interpolation along lines and line strings */
   void setSamplesPerDegree(int value)
   {
@@ -229,6 +239,9 @@ private:
   /* Convert data from U/V components to speed/heading */
   void convertDataset(const atools::grib::GribDatasetVector& datasets);
 
+  /* Update maximum speeds and data version after changing windLayers */
+  void layersChanged();
+
   void gribDownloadFinished(const atools::grib::GribDatasetVector & datasets, QString);
   void gribDownloadFailed(const QString & error, int errorCode, QString);
   void gribFileUpdated(const QString& filename);
@@ -258,6 +271,11 @@ private:
   /* Maps rounded altitude to wind layer data. Sorted by altitude. */
   QMap<int, WindAltLayer> windLayers;
 
+  /* Maximum wind speed for each layer in windLayers */
+  QMap<int, float> maxWindSpeeds;
+
+  quint32 dataVersion = 0;
+
 };
 
 QDebug operator<<(QDebug out, const atools::grib::Wind& wind);
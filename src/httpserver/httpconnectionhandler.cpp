@@ -5,6 +5,7 @@
 
 #include "httpconnectionhandler.h"
 #include "httpresponse.h"
+#include "httpeventstream.h"
 
 using namespace stefanfrings;
 
@@ -18,6 +19,10 @@ HttpConnectionHandler::HttpConnectionHandler(QHash<QString, QVariant> settings,
   this->sslConfiguration = sslConfiguration;
   currentRequest = nullptr;
   busy = false;
+  eventStream = nullptr;
+  eventChunked = false;
+  pendingEventBytes = 0;
+  eventWriteScheduled = false;
 
   // execute signals in a new thread
   thread = new QThread();
@@ -35,6 +40,7 @@ HttpConnectionHandler::HttpConnectionHandler(QHash<QString, QVariant> settings,
   connect(socket, SIGNAL(readyRead()), SLOT(read()));
   connect(socket, SIGNAL(disconnected()), SLOT(disconnected()));
   connect(&readTimer, SIGNAL(timeout()), SLOT(readTimeout()));
+  connect(socket, SIGNAL(bytesWritten(qint64)), SLOT(writeEvents()));
   connect(thread, SIGNAL(finished()), this, SLOT(thread_done()));
 
   qDebug("HttpConnectionHandler (%p): constructed", static_cast<void *>(this));
@@ -50,6 +56,10 @@ void HttpConnectionHandler::thread_done()
 
 HttpConnectionHandler::~HttpConnectionHandler()
 {
+  if(eventStream)
+  {
+    eventStream->unsubscribe(this);
+  }
   thread->quit();
   thread->wait();
   thread->deleteLater();
@@ -135,6 +145,7 @@ void HttpConnectionHandler::readTimeout()
 void HttpConnectionHandler::disconnected()
 {
   qDebug("HttpConnectionHandler (%p): disconnected", static_cast<void *>(this));
+  stopEventStream();
   socket->close();
   readTimer.stop();
   busy = false;
@@ -142,6 +153,13 @@ void HttpConnectionHandler::disconnected()
 
 void HttpConnectionHandler::read()
 {
+  if(eventStream)
+  {
+    // Clients do not send requests on an event stream connection
+    socket->readAll();
+    return;
+  }
+
   // The loop adds support for HTTP pipelinig
   while(socket->bytesAvailable())
   {
@@ -218,6 +236,19 @@ void HttpConnectionHandler::read()
                   static_cast<void *>(this));
       }
 
+      // Keep connection open if the request handler subscribed to an event stream
+      if(response.getEventStream() && !response.hasSentLastPart())
+      {
+        // Send headers only - chunked mode is selected automatically unless the connection is closed
+        response.write(QByteArray(), false);
+        bool chunked = QString::compare(response.getHeaders().value("Transfer-Encoding"), "chunked",
+                                        Qt::CaseInsensitive) == 0;
+        startEventStream(response.getEventStream(), chunked);
+        delete currentRequest;
+        currentRequest = nullptr;
+        return;
+      }
+
       // Finalize sending the response if not already done
       if(!response.hasSentLastPart())
       {
@@ -271,3 +302,123 @@ void HttpConnectionHandler::read()
     }
   }
 }
+
+void HttpConnectionHandler::startEventStream(HttpEventStream *stream, bool chunked)
+{
+  qDebug("HttpConnectionHandler (%p): start event stream", static_cast<void *>(this));
+
+  // Connection is idle until the client disconnects
+  readTimer.stop();
+
+  eventChunked = chunked;
+  eventStream = stream;
+  eventStream->subscribe(this);
+}
+
+void HttpConnectionHandler::stopEventStream()
+{
+  if(eventStream)
+  {
+    qDebug("HttpConnectionHandler (%p): stop event stream", static_cast<void *>(this));
+    eventStream->unsubscribe(this);
+    eventStream = nullptr;
+
+    QMutexLocker locker(&eventMutex);
+    pendingEvents.clear();
+    pendingEventBytes = 0;
+    eventWriteScheduled = false;
+  }
+}
+
+void HttpConnectionHandler::pushEvent(const QByteArray& eventName, const QByteArray& frame, int maxPendingBytes)
+{
+  QMutexLocker locker(&eventMutex);
+
+  // Replace an unsent event of the same name - client gets only the latest state
+  bool replaced = false;
+  if(!eventName.isEmpty())
+  {
+    for(int i = 0; i < pendingEvents.size(); i++)
+    {
+      if(pendingEvents.at(i).first == eventName)
+      {
+        pendingEventBytes += frame.size() - pendingEvents.at(i).second.size();
+        pendingEvents[i].second = frame;
+        replaced = true;
+        break;
+      }
+    }
+  }
+
+  if(!replaced)
+  {
+    pendingEvents.append(qMakePair(eventName, frame));
+    pendingEventBytes += frame.size();
+  }
+
+  // Drop oldest events if the client is too slow
+  while(pendingEventBytes > maxPendingBytes && pendingEvents.size() > 1)
+  {
+    pendingEventBytes -= pendingEvents.takeFirst().second.size();
+  }
+
+  if(!eventWriteScheduled)
+  {
+    // Write in the thread of this connection
+    eventWriteScheduled = true;
+    QMetaObject::invokeMethod(this, "writeEvents", Qt::QueuedConnection);
+  }
+}
+
+void HttpConnectionHandler::writeEvents()
+{
+  if(!eventStream)
+  {
+    // Stream stopped while a write was queued
+    QMutexLocker locker(&eventMutex);
+    eventWriteScheduled = false;
+    return;
+  }
+
+  // Leave events in the queue until the client has read the data sent before.
+  // Called again by the bytesWritten signal.
+  if(socket->bytesToWrite() > 16384)
+  {
+    QMutexLocker locker(&eventMutex);
+    eventWriteScheduled = false;
+    return;
+  }
+
+  QList<QPair<QByteArray, QByteArray> > events;
+  {
+    QMutexLocker locker(&eventMutex);
+    events.swap(pendingEvents);
+    pendingEventBytes = 0;
+    eventWriteScheduled = false;
+  }
+
+  if(events.isEmpty())
+  {
+    return;
+  }
+
+  // Write all events with one call
+  QByteArray buffer;
+  for(int i = 0; i < events.size(); i++)
+  {
+    const QByteArray& frame = events.at(i).second;
+    if(eventChunked)
+    {
+      buffer.append(QByteArray::number(frame.size(), 16));
+      buffer.append("\r\n");
+      buffer.append(frame);
+      buffer.append("\r\n");
+    }
+    else
+    {
+      buffer.append(frame);
+    }
+  }
+  socket->write(buffer);
+  socket->flush();
+}
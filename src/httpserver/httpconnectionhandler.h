@@ -12,12 +12,15 @@
 #include <QTcpSocket>
 #include <QTimer>
 #include <QThread>
+#include <QMutex>
 #include "httpglobal.h"
 #include "httprequest.h"
 #include "httprequesthandler.h"
 
 namespace stefanfrings {
 
+class HttpEventStream;
+
 /** Alias type definition, for compatibility to different Qt versions */
 #if QT_VERSION >= 0x050000
 typedef qintptr tSocketDescriptor;
@@ -71,6 +74,8 @@ public:
   void setBusy();
 
 private:
+  friend class HttpEventStream;
+
   /** Configuration settings */
   QHash<QString, QVariant> settings;
 
@@ -95,9 +100,36 @@ private:
   /** Configuration for SSL */
   const QSslConfiguration *sslConfiguration;
 
+  /** Event stream if the connection was turned into a Server-Sent Events stream. Only accessed in the thread. */
+  HttpEventStream *eventStream;
+
+  /** Events send in chunked mode */
+  bool eventChunked;
+
+  /** Protects pending events which are added by any thread */
+  QMutex eventMutex;
+
+  /** Unsent events with name and formatted data */
+  QList<QPair<QByteArray, QByteArray> > pendingEvents;
+
+  /** Size of pending events */
+  int pendingEventBytes;
+
+  /** A call to writeEvents() is already queued */
+  bool eventWriteScheduled;
+
   /**  Create SSL or TCP socket */
   void createSocket();
 
+  /** Keep connection open and start sending events */
+  void startEventStream(HttpEventStream *stream, bool chunked);
+
+  /** Unsubscribe and drop pending events */
+  void stopEventStream();
+
+  /** Queue event for sending. Called by HttpEventStream in any thread. */
+  void pushEvent(const QByteArray& eventName, const QByteArray& frame, int maxPendingBytes);
+
 public slots:
   /**
    *  Received from from the listener, when the handler shall start processing a new connection.
@@ -118,6 +150,9 @@ private slots:
   /** Cleanup after the thread is closed */
   void thread_done();
 
+  /** Write pending events if the socket output buffer is small enough */
+  void writeEvents();
+
 };
 
 } // end of namespace
@@ -0,0 +1,89 @@
+/**
+ *  @file
+ */
+
+#include "httpeventstream.h"
+#include "httpconnectionhandler.h"
+
+using namespace stefanfrings;
+
+HttpEventStream::HttpEventStream(QObject *parent)
+  : QObject(parent)
+{
+  maxPendingBytes = 65536;
+}
+
+HttpEventStream::~HttpEventStream()
+{
+  QMutexLocker locker(&mutex);
+  if(!subscribers.isEmpty())
+    qWarning("HttpEventStream (%p): destroyed with %d subscribers", static_cast<void *>(this), subscribers.size());
+}
+
+void HttpEventStream::publish(const QByteArray& eventName, const QByteArray& data)
+{
+  // Format only once for all clients
+  QByteArray frame = formatEvent(eventName, data);
+
+  QMutexLocker locker(&mutex);
+  foreach(HttpConnectionHandler * handler, subscribers)
+  {
+    handler->pushEvent(eventName, frame, maxPendingBytes);
+  }
+}
+
+int HttpEventStream::getNumSubscribers() const
+{
+  QMutexLocker locker(&mutex);
+  return subscribers.size();
+}
+
+void HttpEventStream::setMaxPendingBytes(int value)
+{
+  QMutexLocker locker(&mutex);
+  maxPendingBytes = value;
+}
+
+int HttpEventStream::getMaxPendingBytes() const
+{
+  QMutexLocker locker(&mutex);
+  return maxPendingBytes;
+}
+
+QByteArray HttpEventStream::formatEvent(const QByteArray& eventName, const QByteArray& data)
+{
+  QByteArray frame;
+  frame.reserve(eventName.size() + data.size() + 32);
+  if(!eventName.isEmpty())
+  {
+    frame.append("event: ");
+    frame.append(eventName);
+    frame.append('\n');
+  }
+
+  // Each line of data needs its own field
+  foreach(const QByteArray &line, data.split('\n'))
+  {
+    frame.append("data: ");
+    frame.append(line);
+    frame.append('\n');
+  }
+  frame.append('\n');
+  return frame;
+}
+
+void HttpEventStream::subscribe(HttpConnectionHandler *handler)
+{
+  QMutexLocker locker(&mutex);
+  subscribers.insert(handler);
+  qDebug("HttpEventStream (%p): subscribed %p, %d clients", static_cast<void *>(this),
+         static_cast<void *>(handler), subscribers.size());
+}
+
+void HttpEventStream::unsubscribe(HttpConnectionHandler *handler)
+{
+  QMutexLocker locker(&mutex);
+  subscribers.remove(handler);
+  qDebug("HttpEventStream (%p): unsubscribed %p, %d clients", static_cast<void *>(this),
+         static_cast<void *>(handler), subscribers.size());
+}
@@ -0,0 +1,93 @@
+/**
+ *  @file
+ */
+
+#ifndef HTTPEVENTSTREAM_H
+#define HTTPEVENTSTREAM_H
+
+#include <QObject>
+#include <QSet>
+#include <QMutex>
+#include "httpglobal.h"
+
+namespace stefanfrings {
+
+class HttpConnectionHandler;
+
+/**
+ *  Publishes Server-Sent Events to all web clients which subscribed by requesting an event stream.
+ *  <p>
+ *  A request handler subscribes a client by calling HttpResponse::setEventStream() in its
+ *  service() method. The connection then stays open and every event published here is pushed to the
+ *  client until it disconnects. Clients use the browser EventSource API to receive the events.
+ *  <p>
+ *  <code><pre>
+ *   // In the request handler
+ *   if(path == "/events")
+ *     response.setEventStream(eventStream);
+ *
+ *   // Anywhere in the application
+ *   eventStream->publish("aircraft", json);
+ *  </pre></code>
+ *  <p>
+ *  Each client has its own queue. An event which is not sent yet is replaced by a newer event of the
+ *  same name, so slow clients get only the latest state. If the queue grows above the limit the oldest
+ *  events are dropped. Events are only written if the socket output buffer of the client is small.
+ *  <p>
+ *  @warning The stream must be created before and deleted after the HttpListener since connections
+ *  keep a pointer to it. All public methods are thread safe.
+ */
+class DECLSPEC HttpEventStream :
+  public QObject
+{
+  Q_OBJECT
+  Q_DISABLE_COPY(HttpEventStream)
+
+public:
+  /**
+   *  Constructor.
+   *  @param parent Parent object.
+   */
+  HttpEventStream(QObject *parent = nullptr);
+
+  /** Destructor */
+  virtual ~HttpEventStream();
+
+  /**
+   *  Send an event to all subscribed clients.
+   *  @param eventName Name of the event used by the client to select a listener. Unsent events of the same
+   *  name are replaced. An empty name sends a "message" event which is never replaced.
+   *  @param data Event data. Multiple lines are allowed.
+   */
+  void publish(const QByteArray& eventName, const QByteArray& data);
+
+  /** Number of connected clients */
+  int getNumSubscribers() const;
+
+  /** Maximum number of bytes queued for each client. Default is 65536. */
+  void setMaxPendingBytes(int value);
+
+  int getMaxPendingBytes() const;
+
+  /** Format an event in the text/event-stream format */
+  static QByteArray formatEvent(const QByteArray& eventName, const QByteArray& data);
+
+private:
+  friend class HttpConnectionHandler;
+
+  /** Called by connection handlers in their own thread */
+  void subscribe(HttpConnectionHandler *handler);
+  void unsubscribe(HttpConnectionHandler *handler);
+
+  /** Protects all fields */
+  mutable QMutex mutex;
+
+  QSet<HttpConnectionHandler *> subscribers;
+
+  int maxPendingBytes;
+
+};
+
+} // end of namespace
+
+#endif // HTTPEVENTSTREAM_H
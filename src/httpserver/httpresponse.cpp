@@ -5,8 +5,27 @@
 
 #include "httpresponse.h"
 
+#ifndef QT_NO_OPENSSL
+   #include <QSslSocket>
+#endif
+
+#ifdef Q_OS_LINUX
+   #include <sys/sendfile.h>
+   #include <poll.h>
+   #include <errno.h>
+#endif
+
 using namespace stefanfrings;
 
+/** Block writing if more than this amount of data is not yet sent to the client */
+static const qint64 MAX_UNSENT_BYTES = 262144;
+
+/** Give up if the client does not read anything within this time */
+static const int WRITE_TIMEOUT_MS = 30000;
+
+/** Maximum size for one sendfile() call */
+static const qint64 MAX_SENDFILE_BYTES = 1048576;
+
 HttpResponse::HttpResponse(QTcpSocket *socket)
 {
   this->socket = socket;
@@ -15,6 +34,7 @@ HttpResponse::HttpResponse(QTcpSocket *socket)
   sentHeaders = false;
   sentLastPart = false;
   chunkedMode = false;
+  eventStream = nullptr;
 }
 
 void HttpResponse::setHeader(QByteArray name, QByteArray value)
@@ -45,46 +65,48 @@ int HttpResponse::getStatusCode() const
   return this->statusCode;
 }
 
-void HttpResponse::writeHeaders()
+void HttpResponse::appendHeaders(QByteArray& buffer)
 {
   Q_ASSERT(sentHeaders == false);
-  QByteArray buffer;
   buffer.append("HTTP/1.1 ");
   buffer.append(QByteArray::number(statusCode));
   buffer.append(' ');
   buffer.append(statusText);
   buffer.append("\r\n");
-  foreach(QByteArray name, headers.keys())
+  for(QMap<QByteArray, QByteArray>::const_iterator it = headers.constBegin(); it != headers.constEnd(); ++it)
   {
-    buffer.append(name);
+    buffer.append(it.key());
     buffer.append(": ");
-    buffer.append(headers.value(name));
+    buffer.append(it.value());
     buffer.append("\r\n");
   }
-  foreach(HttpCookie cookie, cookies.values())
+  foreach(const HttpCookie &cookie, cookies)
   {
     buffer.append("Set-Cookie: ");
     buffer.append(cookie.toByteArray());
     buffer.append("\r\n");
   }
   buffer.append("\r\n");
-  writeToSocket(buffer);
-  socket->flush();
   sentHeaders = true;
 }
 
-bool HttpResponse::writeToSocket(QByteArray data)
+bool HttpResponse::writeToSocket(const QByteArray& data)
 {
-  int remaining = data.size();
-  char *ptr = data.data();
-  while(socket->isOpen() && remaining > 0)
+  // Wait only if the client is far behind. Otherwise the socket buffers the data and
+  // sends it from the event loop.
+  while(socket->isOpen() && socket->bytesToWrite() > MAX_UNSENT_BYTES)
   {
-    // If the output buffer has become large, then wait until it has been sent.
-    if(socket->bytesToWrite() > 16384)
+    if(!socket->waitForBytesWritten(WRITE_TIMEOUT_MS))
     {
-      socket->waitForBytesWritten(-1);
+      qWarning("HttpResponse: cannot write to socket: %s", qPrintable(socket->errorString()));
+      return false;
     }
+  }
 
+  int remaining = data.size();
+  const char *ptr = data.constData();
+  while(socket->isOpen() && remaining > 0)
+  {
     qint64 written = socket->write(ptr, remaining);
     if(written == -1)
     {
@@ -93,13 +115,16 @@ bool HttpResponse::writeToSocket(QByteArray data)
     ptr += written;
     remaining -= written;
   }
-  return true;
+  return remaining == 0;
 }
 
 void HttpResponse::write(QByteArray data, bool lastPart)
 {
   Q_ASSERT(sentLastPart == false);
 
+  // Headers, chunk framing and data are collected and passed to the socket with a single call
+  QByteArray buffer;
+
   // Send HTTP headers, if not already done (that happens only on the first call to write())
   if(sentHeaders == false)
   {
@@ -122,7 +147,8 @@ void HttpResponse::write(QByteArray data, bool lastPart)
       }
     }
 
-    writeHeaders();
+    buffer.reserve(data.size() + 512);
+    appendHeaders(buffer);
   }
 
   // Send data
@@ -130,33 +156,167 @@ void HttpResponse::write(QByteArray data, bool lastPart)
   {
     if(chunkedMode)
     {
-      if(data.size() > 0)
-      {
-        QByteArray size = QByteArray::number(data.size(), 16);
-        writeToSocket(size);
-        writeToSocket("\r\n");
-        writeToSocket(data);
-        writeToSocket("\r\n");
-      }
+      buffer.reserve(buffer.size() + data.size() + 16);
+      buffer.append(QByteArray::number(data.size(), 16));
+      buffer.append("\r\n");
+      buffer.append(data);
+      buffer.append("\r\n");
+    }
+    else if(buffer.isEmpty())
+    {
+      // Avoid a copy
+      buffer = data;
     }
     else
     {
-      writeToSocket(data);
+      buffer.append(data);
     }
   }
 
   // Only for the last chunk, send the terminating marker and flush the buffer.
+  if(lastPart && chunkedMode)
+  {
+    buffer.append("0\r\n\r\n");
+  }
+
+  writeToSocket(buffer);
+
   if(lastPart)
   {
-    if(chunkedMode)
-    {
-      writeToSocket("0\r\n\r\n");
-    }
     socket->flush();
     sentLastPart = true;
   }
 }
 
+bool HttpResponse::writeFile(QFile& file, qint64 offset, qint64 length)
+{
+  Q_ASSERT(sentHeaders == false);
+  Q_ASSERT(sentLastPart == false);
+
+  headers.insert("Content-Length", QByteArray::number(length));
+  QByteArray buffer;
+  appendHeaders(buffer);
+
+  bool ok = writeToSocket(buffer);
+  if(ok && length > 0)
+  {
+    if(isZeroCopyPossible(file))
+    {
+      ok = sendFileZeroCopy(file, offset, length);
+    }
+    else
+    {
+      ok = sendFileCopy(file, offset, length);
+    }
+  }
+
+  if(!ok)
+  {
+    qWarning("HttpResponse: error sending file %s", qPrintable(file.fileName()));
+  }
+
+  socket->flush();
+  sentLastPart = true;
+  return ok;
+}
+
+bool HttpResponse::isZeroCopyPossible(const QFile& file) const
+{
+#ifdef Q_OS_LINUX
+  #ifndef QT_NO_OPENSSL
+  // Encryption needs the data in user space
+  if(qobject_cast<QSslSocket *>(socket) != nullptr)
+  {
+    return false;
+  }
+  #endif
+
+  // Resource files have no handle
+  return file.handle() != -1 && socket->socketDescriptor() != -1;
+
+#else
+  Q_UNUSED(file);
+  return false;
+
+#endif
+}
+
+bool HttpResponse::sendFileZeroCopy(const QFile& file, qint64 offset, qint64 length)
+{
+#ifdef Q_OS_LINUX
+  // Data buffered by the socket has to go out first since sendfile() bypasses it
+  while(socket->isOpen() && socket->bytesToWrite() > 0)
+  {
+    if(!socket->waitForBytesWritten(WRITE_TIMEOUT_MS))
+    {
+      return false;
+    }
+  }
+
+  int socketHandle = static_cast<int>(socket->socketDescriptor());
+  off_t position = static_cast<off_t>(offset);
+  qint64 remaining = length;
+  while(remaining > 0)
+  {
+    ssize_t sent = ::sendfile(socketHandle, file.handle(), &position,
+                              static_cast<size_t>(qMin(remaining, static_cast<qint64>(MAX_SENDFILE_BYTES))));
+    if(sent > 0)
+    {
+      remaining -= sent;
+    }
+    else if(sent == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    else if(sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+      // Socket is non-blocking - wait until the client has read enough data
+      struct pollfd pollHandle;
+      pollHandle.fd = socketHandle;
+      pollHandle.events = POLLOUT;
+      pollHandle.revents = 0;
+      if(::poll(&pollHandle, 1, WRITE_TIMEOUT_MS) <= 0)
+      {
+        return false;
+      }
+    }
+    else
+    {
+      // Error or file was truncated
+      return false;
+    }
+  }
+  return true;
+
+#else
+  Q_UNUSED(file);
+  Q_UNUSED(offset);
+  Q_UNUSED(length);
+  return false;
+
+#endif
+}
+
+bool HttpResponse::sendFileCopy(QFile& file, qint64 offset, qint64 length)
+{
+  if(!file.seek(offset))
+  {
+    return false;
+  }
+
+  qint64 remaining = length;
+  while(remaining > 0 && socket->isOpen())
+  {
+    QByteArray buffer = file.read(qMin(remaining, static_cast<qint64>(65536)));
+    if(buffer.isEmpty() || !writeToSocket(buffer))
+    {
+      return false;
+    }
+    remaining -= buffer.size();
+  }
+  return remaining == 0;
+}
+
 bool HttpResponse::hasSentLastPart() const
 {
   return sentLastPart;
@@ -192,3 +352,16 @@ bool HttpResponse::isConnected() const
 {
   return socket->isOpen();
 }
+
+void HttpResponse::setEventStream(HttpEventStream *stream)
+{
+  Q_ASSERT(sentHeaders == false);
+  eventStream = stream;
+  setHeader("Content-Type", "text/event-stream");
+  setHeader("Cache-Control", "no-cache");
+}
+
+HttpEventStream *HttpResponse::getEventStream() const
+{
+  return eventStream;
+}
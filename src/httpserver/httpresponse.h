@@ -9,11 +9,14 @@
 #include <QMap>
 #include <QString>
 #include <QTcpSocket>
+#include <QFile>
 #include "httpglobal.h"
 #include "httpcookie.h"
 
 namespace stefanfrings {
 
+class HttpEventStream;
+
 /**
  *  This object represents a HTTP response, used to return something to the web client.
  *  <p>
@@ -90,6 +93,21 @@ public:
    */
   void write(const QByteArray data, const bool lastPart = false);
 
+  /**
+   *  Write a part of a file as the complete body and finish the response.
+   *  <p>
+   *  The HTTP status line, headers and cookies are sent automatically before the body
+   *  and the Content-Length header is set to length.
+   *  On Linux the file is sent with sendfile() without copying it through user space
+   *  if the file has a handle and the connection is not encrypted.
+   *  You must not call write() before or after this method.
+   *  @param file Opened file
+   *  @param offset Start of the body in the file
+   *  @param length Number of bytes to send
+   *  @return false if an error occurred while sending
+   */
+  bool writeFile(QFile& file, qint64 offset, qint64 length);
+
   /**
    *  Indicates whether the body has been sent completely (write() has been called with lastPart=true).
    */
@@ -121,6 +139,19 @@ public:
    */
   bool isConnected() const;
 
+  /**
+   *  Turn this response into a Server-Sent Events stream.
+   *  <p>
+   *  Sets the required headers. The connection stays open after HttpRequestHandler::service()
+   *  returns and all events published to the stream are sent to the client until it disconnects.
+   *  Do not call write() after this.
+   *  @param stream Stream providing the events
+   */
+  void setEventStream(HttpEventStream *stream);
+
+  /** Returns the stream set by setEventStream() or null */
+  HttpEventStream *getEventStream() const;
+
 private:
   /** Request headers */
   QMap<QByteArray, QByteArray> headers;
@@ -146,15 +177,26 @@ private:
   /** Cookies */
   QMap<QByteArray, HttpCookie> cookies;
 
-  /** Write raw data to the socket. This method blocks until all bytes have been passed to the TCP buffer */
-  bool writeToSocket(QByteArray data);
+  /** Event stream if this is a Server-Sent Events response */
+  HttpEventStream *eventStream;
 
   /**
-   *  Write the response HTTP status and headers to the socket.
-   *  Calling this method is optional, because writeBody() calls
-   *  it automatically when required.
+   *  Pass raw data to the socket. This method blocks only if the socket has a large amount of
+   *  unsent data, i.e. the client does not read fast enough.
    */
-  void writeHeaders();
+  bool writeToSocket(const QByteArray& data);
+
+  /** Append the response HTTP status, headers and cookies to the buffer and mark headers as sent */
+  void appendHeaders(QByteArray& buffer);
+
+  /** true if writeFile() can use sendfile() for this file */
+  bool isZeroCopyPossible(const QFile& file) const;
+
+  /** Send file part directly from the file to the socket descriptor. Only available on Linux. */
+  bool sendFileZeroCopy(const QFile& file, qint64 offset, qint64 length);
+
+  /** Send file part by reading blocks and passing them to the socket */
+  bool sendFileCopy(QFile& file, qint64 offset, qint64 length);
 
 };
 
@@ -47,7 +47,7 @@ void StaticFileController::service(HttpRequest& request, HttpResponse& response)
     qDebug("StaticFileController: Cache hit for %s", path.data());
     setContentType(filename, response);
     response.setHeader("Cache-Control", "max-age=" + QByteArray::number(maxAge / 1000));
-    response.write(document);
+    writeDocument(request, response, document);
   }
   else
   {
@@ -78,24 +78,22 @@ void StaticFileController::service(HttpRequest& request, HttpResponse& response)
       {
         // Return the file content and store it also in the cache
         entry = new CacheEntry();
-        while(!file.atEnd() && !file.error())
-        {
-          QByteArray buffer = file.read(65536);
-          response.write(buffer);
-          entry->document.append(buffer);
-        }
+        entry->document = file.readAll();
         entry->created = now;
         entry->filename = path;
+        QByteArray document = entry->document;
         mutex.lock();
         cache.insert(request.getPath(), entry, entry->document.size());
         mutex.unlock();
+        writeDocument(request, response, document);
       }
       else
       {
         // Return the file content, do not store in cache
-        while(!file.atEnd() && !file.error())
+        qint64 start, length;
+        if(prepareRange(request, response, file.size(), start, length))
         {
-          response.write(file.read(65536));
+          response.writeFile(file, start, length);
         }
       }
       file.close();
@@ -117,6 +115,100 @@ void StaticFileController::service(HttpRequest& request, HttpResponse& response)
   }
 }
 
+void StaticFileController::writeDocument(const HttpRequest& request, HttpResponse& response,
+                                         const QByteArray& document) const
+{
+  qint64 start, length;
+  if(prepareRange(request, response, document.size(), start, length))
+  {
+    if(start == 0 && length == document.size())
+    {
+      response.write(document, true);
+    }
+    else
+    {
+      response.write(document.mid(static_cast<int>(start), static_cast<int>(length)), true);
+    }
+  }
+}
+
+bool StaticFileController::prepareRange(const HttpRequest& request, HttpResponse& response, qint64 size,
+                                        qint64& start, qint64& length) const
+{
+  response.setHeader("Accept-Ranges", "bytes");
+
+  // Send whole file by default
+  start = 0;
+  length = size;
+
+  // Only a single range is supported - send whole file for invalid or multiple ranges
+  QByteArray range = request.getHeader("Range").trimmed();
+  if(!range.startsWith("bytes=") || range.contains(','))
+  {
+    return true;
+  }
+
+  QByteArray spec = range.mid(6);
+  int dash = spec.indexOf('-');
+  if(dash == -1)
+  {
+    return true;
+  }
+
+  QByteArray firstStr = spec.left(dash).trimmed(), lastStr = spec.mid(dash + 1).trimmed();
+  bool ok;
+  qint64 first, last;
+  if(firstStr.isEmpty())
+  {
+    // "bytes=-500" - the last 500 bytes
+    qint64 suffix = lastStr.toLongLong(&ok);
+    if(!ok || suffix < 0)
+    {
+      return true;
+    }
+    first = qMax(static_cast<qint64>(0), size - suffix);
+    last = size - 1;
+  }
+  else
+  {
+    // "bytes=500-" or "bytes=500-999"
+    first = firstStr.toLongLong(&ok);
+    if(!ok || first < 0)
+    {
+      return true;
+    }
+
+    if(lastStr.isEmpty())
+    {
+      last = size - 1;
+    }
+    else
+    {
+      last = lastStr.toLongLong(&ok);
+      if(!ok || last < first)
+      {
+        return true;
+      }
+      last = qMin(last, size - 1);
+    }
+  }
+
+  if(first >= size || first > last)
+  {
+    response.setStatus(416, "range not satisfiable");
+    response.setHeader("Content-Range", "bytes */" + QByteArray::number(size));
+    response.write("416 range not satisfiable", true);
+    return false;
+  }
+
+  start = first;
+  length = last - first + 1;
+  response.setStatus(206, "partial content");
+  response.setHeader("Content-Range", "bytes " + QByteArray::number(first) + "-" + QByteArray::number(last) + "/" +
+                     QByteArray::number(size));
+  return true;
+}
+
 void StaticFileController::setContentType(const QString fileName, HttpResponse& response) const
 {
   if(fileName.endsWith(".png"))
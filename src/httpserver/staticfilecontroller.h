@@ -34,9 +34,12 @@ namespace stefanfrings {
  *  The encoding is sent to the web browser in case of text and html files.
  *  <p>
  *  The cache improves performance of small files when loaded from a network
- *  drive. Large files are not cached. Files are cached as long as possible,
+ *  drive. Large files are not cached and sent with sendfile() on Linux. Files are cached as long as possible,
  *  when cacheTime=0. The maxAge value (in msec!) controls the remote browsers cache.
  *  <p>
+ *  Single byte ranges in the "Range" request header are supported to allow resuming
+ *  downloads.
+ *  <p>
  *  Do not instantiate this class in each request, because this would make the file cache
  *  useless. Better create one instance during start-up and call it when the application
  *  received a related HTTP request.
@@ -93,6 +96,17 @@ private:
   /** Used to synchronize cache access for threads */
   QMutex mutex;
 
+  /** Send a cached or small document. Takes the range header into account. */
+  void writeDocument(const HttpRequest& request, HttpResponse& response, const QByteArray& document) const;
+
+  /**
+   *  Evaluate a "Range: bytes=" request header and set status and response headers accordingly.
+   *  start and length cover the whole file if there is no range or the range is invalid.
+   *  @return false if the range cannot be satisfied. A 416 response is already sent in this case.
+   */
+  bool prepareRange(const HttpRequest& request, HttpResponse& response, qint64 size,
+                    qint64& start, qint64& length) const;
+
   /** Set a content-type header in the response depending on the ending of the filename */
   void setContentType(const QString file, HttpResponse& response) const;
 
@@ -158,18 +158,43 @@ QChar BinaryStream::readChar()
 
 QString BinaryStream::readString()
 {
-  QString retval;
-  char c = 0;
-  while((c = readByte()) != 0)
+  // Read blocks directly from the device which avoids checking the stream for each character
+  // QDataStream does not buffer data so positions stay in sync
+  QIODevice *device = is->device();
+  char buffer[256];
+  QByteArray bytes;
+  while(true)
   {
-    if(iscntrl(c))
+    qint64 pos = device->pos();
+    int numRead = static_cast<int>(device->read(buffer, sizeof(buffer)));
+    if(numRead <= 0)
+    {
+      // End of file before terminating null - let the stream report the error
+      device->seek(pos);
+      readByte();
       break;
-    retval.append(QChar::fromLatin1(c));
+    }
+
+    int len = 0;
+    while(len < numRead && buffer[len] != 0 && !iscntrl(buffer[len]))
+      len++;
+
+    if(len < numRead)
+    {
+      // Found terminating null or control character - skip it
+      device->seek(pos + len + 1);
+      if(bytes.isEmpty())
+        return QString::fromLatin1(buffer, len);
+
+      bytes.append(buffer, len);
+      break;
+    }
+    bytes.append(buffer, len);
   }
 
   checkStream("readString");
 
-  return retval;
+  return QString::fromLatin1(bytes);
 }
 
 QString BinaryStream::readString(int length)
@@ -177,22 +202,21 @@ QString BinaryStream::readString(int length)
   char *buf = new char[length];
   readBytes(buf, length);
 
-  QString retval;
-  for(int i = 0; i < length; i++)
-  {
-    if(iscntrl(buf[i]))
-      break;
-    retval.append(QChar::fromLatin1(buf[i]));
-  }
+  int len = 0;
+  while(len < length && !iscntrl(buf[len]))
+    len++;
+
+  QString retval = QString::fromLatin1(buf, len);
   delete[] buf;
   return retval;
 }
 
-void BinaryStream::checkStream(const QString& what) const
+void BinaryStream::checkStream(const char *what) const
 {
   if(is->status() != QDataStream::Ok)
   {
-    QString msg = QString("%1 for file \"%2\" failed. Reason %3").arg(what).arg(getFilename()).arg(is->status());
+    QString msg = QString("%1 for file \"%2\" failed. Reason %3").
+                  arg(QLatin1String(what)).arg(getFilename()).arg(is->status());
 
     qWarning() << msg << "Position" << hex << "0x" << is->device()->pos() << dec << is->device()->pos();
     throw Exception(msg);
@@ -67,7 +67,8 @@ public:
   QString getFilename() const;
 
 private:
-  void checkStream(const QString& what) const;
+  /* Parameter is a plain string to avoid allocations for each read */
+  void checkStream(const char *what) const;
 
   QDataStream *is;
   QFile *file;
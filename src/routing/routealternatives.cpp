@@ -0,0 +1,157 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "routing/routealternatives.h"
+
+#include "routing/routenetwork.h"
+
+#include <QElapsedTimer>
+
+using atools::geo::Pos;
+
+namespace atools {
+namespace routing {
+
+RouteAlternatives::RouteAlternatives(RouteFinder *routeFinder)
+  : finder(routeFinder)
+{
+}
+
+int RouteAlternatives::calculateAlternatives(QVector<RouteAlternative>& routes, const Pos& from, const Pos& to,
+                                             int flownAltitude, Modes modeParam, int number)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  routes.clear();
+
+  // Penalties only increase costs - incremental mode can reuse estimates between iterations
+  // Penalties set by the caller are kept and restored afterwards
+  bool incremental = finder->isIncremental();
+  QHash<quint64, float> callerPenalties = finder->getEdgePenalties();
+  finder->setIncremental(true);
+
+  // Edges for each accepted route
+  QVector<QSet<quint64> > routeEdgeSets;
+  float bestDistanceMeter = 0.f;
+  int iterations = 0, maxIterations = number * maxIterationsFactor;
+
+  while(routes.size() < number && iterations++ < maxIterations)
+  {
+    if(!finder->calculateRoute(from, to, flownAltitude, modeParam))
+      // Nothing found or canceled
+      break;
+
+    RouteAlternative route;
+    finder->extractLegs(route.legs, route.distanceMeter);
+
+    if(routes.isEmpty())
+      bestDistanceMeter = route.distanceMeter;
+    else
+    {
+      route.detourRatio = bestDistanceMeter > 0.f ? route.distanceMeter / bestDistanceMeter : 1.f;
+
+      if(route.detourRatio > maxDetourRatio)
+        // Penalties will make further routes only longer
+        break;
+
+      for(const QSet<quint64>& edges : routeEdgeSets)
+        route.overlap = std::max(route.overlap, routeOverlap(route, from, to, edges));
+    }
+
+    // Push next search away from this route - also if not accepted
+    penalizeRoute(route);
+
+    if(routes.isEmpty() || route.overlap <= maxOverlap)
+    {
+      QSet<quint64> edges;
+      routeEdges(edges, route.legs);
+      routeEdgeSets.append(edges);
+      routes.append(route);
+    }
+  }
+
+  // Costs decrease again - resets incremental state
+  finder->setEdgePenalties(callerPenalties);
+  finder->setIncremental(incremental);
+
+  qDebug() << Q_FUNC_INFO << "found" << routes.size() << "iterations" << iterations << timer.elapsed() << "ms";
+
+  return routes.size();
+}
+
+void RouteAlternatives::routeEdges(QSet<quint64>& edges, const QVector<RouteLeg>& legs) const
+{
+  int last = Node::DEPARTURE_INDEX;
+  for(const RouteLeg& leg : legs)
+  {
+    edges.insert(RouteFinder::edgeKey(last, leg.nodeIndex));
+    last = leg.nodeIndex;
+  }
+  edges.insert(RouteFinder::edgeKey(last, Node::DESTINATION_INDEX));
+}
+
+float RouteAlternatives::routeOverlap(const RouteAlternative& route, const Pos& from, const Pos& to,
+                                      const QSet<quint64>& edges) const
+{
+  if(!(route.distanceMeter > 0.f))
+    return 1.f;
+
+  float sharedMeter = 0.f;
+  int lastIndex = Node::DEPARTURE_INDEX;
+  Pos lastPos = from;
+  for(const RouteLeg& leg : route.legs)
+  {
+    if(edges.contains(RouteFinder::edgeKey(lastIndex, leg.nodeIndex)))
+      sharedMeter += lastPos.distanceMeterTo(leg.pos);
+    lastIndex = leg.nodeIndex;
+    lastPos = leg.pos;
+  }
+
+  if(edges.contains(RouteFinder::edgeKey(lastIndex, Node::DESTINATION_INDEX)))
+    sharedMeter += lastPos.distanceMeterTo(to);
+
+  return sharedMeter / route.distanceMeter;
+}
+
+void RouteAlternatives::penalizeRoute(const RouteAlternative& route)
+{
+  int last = Node::DEPARTURE_INDEX;
+  for(const RouteLeg& leg : route.legs)
+  {
+    finder->setEdgePenalty(last, leg.nodeIndex, finder->getEdgePenalty(last, leg.nodeIndex) * penaltyFactor);
+    last = leg.nodeIndex;
+  }
+  finder->setEdgePenalty(last, Node::DESTINATION_INDEX,
+                         finder->getEdgePenalty(last, Node::DESTINATION_INDEX) * penaltyFactor);
+}
+
+QDebug operator<<(QDebug out, const RouteAlternative& obj)
+{
+  QDebugStateSaver saver(out);
+
+  out.nospace().noquote() << "RouteAlternative("
+                          << "legs " << obj.legs.size()
+                          << ", distance " << obj.distanceMeter
+                          << ", overlap " << obj.overlap
+                          << ", detour " << obj.detourRatio
+                          << ")";
+  return out;
+}
+
+} // namespace routing
+} // namespace atools
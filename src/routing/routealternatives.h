@@ -0,0 +1,118 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_ROUTING_ROUTEALTERNATIVES_H
+#define ATOOLS_ROUTING_ROUTEALTERNATIVES_H
+
+#include "routing/routefinder.h"
+
+namespace atools {
+namespace routing {
+
+/* One route found by RouteAlternatives */
+struct RouteAlternative
+{
+  QVector<atools::routing::RouteLeg> legs; /* Legs not including departure and destination as in RouteFinder */
+  float distanceMeter = 0.f; /* Total distance including departure and destination */
+
+  /* Fraction of the distance which is shared with the best of all other previously found routes. 0 for first route. */
+  float overlap = 0.f;
+
+  /* Distance divided by distance of the first (best) route. 1 for first route. */
+  float detourRatio = 1.f;
+
+  friend QDebug operator<<(QDebug out, const atools::routing::RouteAlternative& obj);
+
+};
+
+/*
+ * Finds a number of sufficiently different routes between two points using the penalty method.
+ *
+ * The first route is the one found by RouteFinder. After each search the costs of all edges of the found route
+ * are multiplied by a penalty factor which pushes the next search away from it. A route is accepted if
+ * its overlap with all accepted routes and its detour ratio are below the configured limits.
+ *
+ * Searches use the incremental mode of RouteFinder since costs only increase between iterations.
+ * The estimates learned in the first search keep the following searches small.
+ *
+ * The class is not re-entrant and changes the state of the route finder while calculating. Edge penalties
+ * set by the caller are applied to all searches and restored afterwards.
+ *
+ * The route finder keeps the result of the last search which can be a rejected alternative. Use the routes
+ * returned by calculateAlternatives() or call RouteFinder::calculateRoute() again to get the best route
+ * from the finder.
+ */
+class RouteAlternatives
+{
+public:
+  /* Route finder is not owned */
+  RouteAlternatives(atools::routing::RouteFinder *routeFinder);
+
+  /*
+   * Calculate up to number routes. Parameters are the same as for RouteFinder::calculateRoute.
+   * Routes are sorted by order found which is usually by increasing distance.
+   * @return number of routes found
+   */
+  int calculateAlternatives(QVector<atools::routing::RouteAlternative>& routes, const atools::geo::Pos& from,
+                            const atools::geo::Pos& to, int flownAltitude, atools::routing::Modes modeParam,
+                            int number);
+
+  /* Factor for edges of found routes. Applied repeatedly if a route is found more than once. */
+  void setPenaltyFactor(float value)
+  {
+    penaltyFactor = value;
+  }
+
+  /* Accept routes sharing at most this fraction of their distance with any other route. 0 to 1. */
+  void setMaxOverlap(float value)
+  {
+    maxOverlap = value;
+  }
+
+  /* Accept routes being at most this factor longer than the best route. */
+  void setMaxDetourRatio(float value)
+  {
+    maxDetourRatio = value;
+  }
+
+  /* Maximum number of searches including rejected routes is number multiplied by this value */
+  void setMaxIterationsFactor(int value)
+  {
+    maxIterationsFactor = value;
+  }
+
+private:
+  /* Add edges of the route to the set. Includes departure and destination edges. */
+  void routeEdges(QSet<quint64>& edges, const QVector<atools::routing::RouteLeg>& legs) const;
+
+  /* Get fraction of route distance covered by edges */
+  float routeOverlap(const atools::routing::RouteAlternative& route, const atools::geo::Pos& from,
+                     const atools::geo::Pos& to, const QSet<quint64>& edges) const;
+
+  /* Multiply costs of all route edges by the penalty factor */
+  void penalizeRoute(const atools::routing::RouteAlternative& route);
+
+  atools::routing::RouteFinder *finder;
+
+  float penaltyFactor = 1.4f, maxOverlap = 0.6f, maxDetourRatio = 1.3f;
+  int maxIterationsFactor = 3;
+};
+
+} // namespace routing
+} // namespace atools
+
+#endif // ATOOLS_ROUTING_ROUTEALTERNATIVES_H
@@ -18,11 +18,13 @@
 #include "routing/routefinder.h"
 
 #include "routing/routenetwork.h"
+#include "geo/calculations.h"
 #include "atools.h"
 
 #include <QElapsedTimer>
 
 using atools::geo::Pos;
+using atools::grib::Wind;
 
 namespace atools {
 namespace routing {
@@ -43,6 +45,7 @@ RouteFinder::RouteFinder(RouteNetwork *routeNetwork)
 RouteFinder::~RouteFinder()
 {
   freeArrays();
+  freeIncrementalArrays();
 }
 
 bool RouteFinder::calculateRoute(const atools::geo::Pos& from, const atools::geo::Pos& to, int flownAltitude,
@@ -62,6 +65,24 @@ bool RouteFinder::calculateRoute(const atools::geo::Pos& from, const atools::geo
   destNode = network->getDestinationNode();
   distMeterToDest = currentDistMeterToDest = atools::roundToInt(network->getDirectDistanceMeter(startNode, destNode));
 
+  // Use travel time as costs if winds are available ==========================
+  useWind = windQuery != nullptr && windQuery->hasWindData() && altitude > 0 && trueAirspeed > 0.f;
+  if(useWind)
+  {
+    updateWindCache();
+
+    // Ground speed cannot be higher than TAS plus maximum wind anywhere - keeps the estimate admissible
+    costEstimateFactor = trueAirspeed / (trueAirspeed + windQuery->getMaxWindSpeed(altitude));
+  }
+  else
+    costEstimateFactor = 1.f;
+
+  // Reuse or reset state of earlier searches ==========================
+  updateIncremental();
+  closedNodeIndexes.clear();
+  shortcutIndex = -1;
+
+  openNodesHeap.clear();
   openNodesHeap.pushData(startNode.index, 0.f);
   at(nodeAltRangeMaxArr, startNode.index) = std::numeric_limits<quint16>::max();
 
@@ -74,6 +95,9 @@ bool RouteFinder::calculateRoute(const atools::geo::Pos& from, const atools::geo
 
     if(currentIndex == destNode.index)
     {
+      if(shortcutIndex != -1)
+        // Reached destination using a path from an earlier search - copy it into the current search
+        unrollStoredPath(shortcutIndex);
       destinationFound = true;
       break;
     }
@@ -96,11 +120,23 @@ bool RouteFinder::calculateRoute(const atools::geo::Pos& from, const atools::geo
     // Contains nodes with known shortest path
     at(closedNodes, currentNode.index) = true;
 
+    if(incrementalValid)
+    {
+      closedNodeIndexes.append(currentNode.index);
+      relaxStoredPath(currentNode);
+    }
+
     // Work on successors
     expandNode(currentNode);
   }
 
+  if(destinationFound && incrementalValid)
+    learnFromSearch();
+
   qDebug() << Q_FUNC_INFO << "found" << destinationFound << "heap size" << openNodesHeap.size()
+           << "wind" << useWind << "wind cache size" << edgeWindCache.size()
+           << "incremental" << incrementalValid << "closed" << closedNodeIndexes.size()
+           << "shortcut" << shortcutIndex
            << timer.restart() << "ms";
 
   return destinationFound;
@@ -133,6 +169,10 @@ void RouteFinder::expandNode(const atools::routing::Node& currentNode)
       // Already has a shortest path
       continue;
 
+    if(!blockedEdges.isEmpty() && blockedEdges.contains(edgeKey(currentNode.index, successorIndex)))
+      // Excluded by user
+      continue;
+
     const Node& successor = network->getNode(successorIndex);
     const Edge& edge = successors.edges.at(i);
 
@@ -142,6 +182,10 @@ void RouteFinder::expandNode(const atools::routing::Node& currentNode)
     if(currentNodeAirwayHash != edge.airwayHash)
       successorEdgeCosts *= COST_FACTOR_AIRWAY_CHANGE;
 
+    if(!edgePenalties.isEmpty())
+      // Penalty set by user or for alternative routes
+      successorEdgeCosts *= edgePenalties.value(edgeKey(currentNode.index, successorIndex), 1.f);
+
     float successorNodeCosts = at(nodeCostArr, currentNode.index) + successorEdgeCosts;
 
     if(successorNodeCosts >= at(nodeCostArr, successorIndex) && openNodesHeap.contains(successorIndex))
@@ -163,6 +207,10 @@ void RouteFinder::expandNode(const atools::routing::Node& currentNode)
     at(nodeAltRangeMinArr, successorIndex) = successorNodeAltRangeMin;
     at(nodeAltRangeMaxArr, successorIndex) = successorNodeAltRangeMax;
 
+    if(successorIndex == destNode.index)
+      // Found a better connection than a stored path
+      shortcutIndex = -1;
+
     // Costs from start to successor + estimate to destination = sort order in heap
     float totalCost = successorNodeCosts + costEstimate(successor, destNode);
 
@@ -184,11 +232,82 @@ bool RouteFinder::combineRanges(quint16 min1, quint16 max1, quint16 min, quint16
   return true;
 }
 
+float RouteFinder::calculateEdgeBaseCost(const atools::routing::Node& currentNode,
+                                         const atools::routing::Node& successorNode,
+                                         const atools::routing::Edge& edge)
+{
+  if(!useWind)
+    return edge.lengthMeter;
+
+  Wind wind = edgeWind(currentNode, successorNode);
+  float course = currentNode.pos.angleDegTo(successorNode.pos);
+  float groundSpeed = atools::geo::windCorrectedGroundSpeed(wind.speed, wind.dir, course, trueAirspeed);
+
+  // Invalid if wind is stronger than aircraft or course is not defined
+  if(!(groundSpeed < atools::geo::INVALID_FLOAT / 2.f))
+    groundSpeed = wind.isNull() ? trueAirspeed : trueAirspeed * MIN_GROUND_SPEED_FACTOR;
+  groundSpeed = std::max(groundSpeed, trueAirspeed * MIN_GROUND_SPEED_FACTOR);
+
+  // Distance flown in still air in the same time - proportional to travel time
+  return edge.lengthMeter * trueAirspeed / groundSpeed;
+}
+
+Wind RouteFinder::edgeWind(const atools::routing::Node& currentNode, const atools::routing::Node& successorNode)
+{
+  if(currentNode.index < 0 || successorNode.index < 0)
+    // Virtual departure or destination node - position changes for each calculation
+    return windQuery->getWindAverageForLine(currentNode.pos.alt(altitude), successorNode.pos.alt(altitude));
+
+  quint64 key = edgeKey(currentNode.index, successorNode.index);
+  QHash<quint64, Wind>::const_iterator it = edgeWindCache.constFind(key);
+  if(it != edgeWindCache.constEnd())
+    return it.value();
+
+  Wind wind = windQuery->getWindAverageForLine(currentNode.pos.alt(altitude), successorNode.pos.alt(altitude));
+  edgeWindCache.insert(key, wind);
+  return wind;
+}
+
+void RouteFinder::updateWindCache()
+{
+  if(windQuery->getDataVersion() != windCacheDataVersion || altitude != windCacheAltitude ||
+     network->getLoadCounter() != windCacheNetworkCounter)
+  {
+    // New GFS cycle, different altitude or reloaded network
+    edgeWindCache.clear();
+    windCacheDataVersion = windQuery->getDataVersion();
+    windCacheAltitude = altitude;
+    windCacheNetworkCounter = network->getLoadCounter();
+  }
+}
+
+void RouteFinder::precalculateEdgeWinds(int flownAltitude)
+{
+  if(windQuery == nullptr || !windQuery->hasWindData() || flownAltitude <= 0)
+    return;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  ensureNetworkLoaded();
+
+  altitude = flownAltitude;
+  updateWindCache();
+
+  for(const Node& node : network->getNodes())
+  {
+    for(const Edge& edge : node.edges)
+      edgeWind(node, network->getNode(edge.toIndex));
+  }
+
+  qDebug() << Q_FUNC_INFO << "wind cache size" << edgeWindCache.size() << timer.restart() << "ms";
+}
+
 float RouteFinder::calculateEdgeCost(const atools::routing::Node& currentNode,
                                      const atools::routing::Node& successorNode,
                                      const atools::routing::Edge& edge)
 {
-  float costs = edge.lengthMeter;
+  float costs = calculateEdgeBaseCost(currentNode, successorNode, edge);
 
   if(currentNode.type == atools::routing::DEPARTURE && successorNode.type == atools::routing::DESTINATION)
     // Avoid direct connections between departure and destination
@@ -251,7 +370,212 @@ float RouteFinder::calculateEdgeCost(const atools::routing::Node& currentNode,
 
 float RouteFinder::costEstimate(const atools::routing::Node& currentNode, const atools::routing::Node& nextNode)
 {
-  return network->getGcDistanceMeter(currentNode, nextNode);
+  float estimate = network->getGcDistanceMeter(currentNode, nextNode) * costEstimateFactor;
+
+  if(incrementalValid && currentNode.index >= 0)
+    // Use estimate learned from earlier searches if better
+    estimate = std::max(estimate, at(nodeEstimateArr, currentNode.index));
+
+  return estimate;
+}
+
+void RouteFinder::setIncremental(bool value)
+{
+  incremental = value;
+  if(!incremental)
+    resetIncremental();
+}
+
+void RouteFinder::resetIncremental()
+{
+  freeIncrementalArrays();
+  incrementalValid = false;
+  incrementalParameters = IncrementalParameters();
+}
+
+void RouteFinder::blockEdge(int fromIndex, int toIndex)
+{
+  blockedEdges.insert(edgeKey(fromIndex, toIndex));
+
+  // Costs can only increase - estimates remain valid. Break stored paths using this edge.
+  // All paths passing this node are invalid too since they are checked when used.
+  if(pathNextArr != nullptr && fromIndex >= 0 && at(pathNextArr, fromIndex) == toIndex)
+    at(pathNextArr, fromIndex) = -1;
+}
+
+void RouteFinder::clearBlockedEdges()
+{
+  if(!blockedEdges.isEmpty())
+  {
+    blockedEdges.clear();
+    resetIncremental();
+  }
+}
+
+void RouteFinder::setEdgePenalty(int fromIndex, int toIndex, float factor)
+{
+  Q_ASSERT(factor >= 1.f);
+  edgePenalties.insert(edgeKey(fromIndex, toIndex), factor);
+
+  // Same as for blocked edges - estimates are still valid since costs only increase
+  if(pathNextArr != nullptr && fromIndex >= 0 && at(pathNextArr, fromIndex) == toIndex)
+    at(pathNextArr, fromIndex) = -1;
+}
+
+void RouteFinder::setEdgePenalties(const QHash<quint64, float>& penalties)
+{
+  edgePenalties = penalties;
+  resetIncremental();
+}
+
+void RouteFinder::clearEdgePenalties()
+{
+  if(!edgePenalties.isEmpty())
+  {
+    edgePenalties.clear();
+    resetIncremental();
+  }
+}
+
+bool RouteFinder::IncrementalParameters::operator==(const IncrementalParameters& other) const
+{
+  return destination == other.destination && altitude == other.altitude && mode == other.mode &&
+         networkLoadCounter == other.networkLoadCounter && windDataVersion == other.windDataVersion &&
+         atools::almostEqual(trueAirspeed, other.trueAirspeed) && useWind == other.useWind &&
+         preferVorToAirway == other.preferVorToAirway && preferNdbToAirway == other.preferNdbToAirway;
+}
+
+void RouteFinder::updateIncremental()
+{
+  if(!incremental)
+  {
+    incrementalValid = false;
+    return;
+  }
+
+  IncrementalParameters parameters;
+  parameters.destination = destNode.pos;
+  parameters.altitude = altitude;
+  parameters.mode = mode;
+  parameters.networkLoadCounter = network->getLoadCounter();
+  parameters.windDataVersion = useWind ? windQuery->getDataVersion() : 0;
+  parameters.trueAirspeed = useWind ? trueAirspeed : 0.f;
+  parameters.useWind = useWind;
+  parameters.preferVorToAirway = preferVorToAirway;
+  parameters.preferNdbToAirway = preferNdbToAirway;
+
+  if(!incrementalValid || parameters != incrementalParameters)
+  {
+    // Costs might have changed - start over
+    allocIncrementalArrays();
+    incrementalParameters = parameters;
+    incrementalValid = true;
+  }
+}
+
+void RouteFinder::relaxStoredPath(const atools::routing::Node& node)
+{
+  if(node.index < 0)
+    return;
+
+  float pathCosts = storedPathCosts(node.index, at(nodeAirwayArr, node.index));
+  if(pathCosts < 0.f)
+    return;
+
+  float destCosts = at(nodeCostArr, node.index) + pathCosts;
+  bool destOpen = openNodesHeap.contains(destNode.index);
+  if(destOpen && destCosts >= at(nodeCostArr, destNode.index))
+    // Known connection is cheaper
+    return;
+
+  // Remember node and add destination - path is copied when destination is taken from the heap
+  at(nodePredecessorArr, destNode.index) = node.index;
+  at(nodeCostArr, destNode.index) = destCosts;
+  shortcutIndex = node.index;
+
+  if(destOpen)
+    openNodesHeap.change(destNode.index, destCosts);
+  else
+    openNodesHeap.push(destNode.index, destCosts);
+}
+
+float RouteFinder::storedPathCosts(int index, quint32 airwayHash) const
+{
+  // Remaining costs depend on the airway change factor at this node
+  if(at(pathNextArr, index) == -1 || at(pathAirwayInArr, index) != airwayHash)
+    return -1.f;
+
+  float costs = 0.f;
+  int current = index;
+  while(current != Node::DESTINATION_INDEX)
+  {
+    int next = at(pathNextArr, current);
+
+    if(next == -1)
+      // Broken by blocked edge
+      return -1.f;
+
+    if(next >= 0 && at(pathAirwayInArr, next) != at(pathAirwayOutArr, current))
+      // Next node was overwritten by a path using another airway
+      return -1.f;
+
+    if(at(closedNodes, next))
+      // Do not loop back into the current search tree - closed nodes use their own stored path
+      return -1.f;
+
+    costs += at(pathCostArr, current);
+    current = next;
+  }
+  return costs;
+}
+
+void RouteFinder::unrollStoredPath(int index)
+{
+  int current = index;
+  while(current != Node::DESTINATION_INDEX)
+  {
+    int next = at(pathNextArr, current);
+    at(nodePredecessorArr, next) = current;
+    at(nodeAirwayIdArr, next) = at(pathAirwayIdArr, current);
+    at(nodeAirwayArr, next) = at(pathAirwayOutArr, current);
+    at(nodeCostArr, next) = at(nodeCostArr, current) + at(pathCostArr, current);
+    current = next;
+  }
+}
+
+void RouteFinder::learnFromSearch()
+{
+  float destCosts = at(nodeCostArr, destNode.index);
+
+  // Costs to destination cannot be lower than the difference for all nodes having a known shortest path.
+  // The costs of the first edge leaving a node depend on the incoming airway. Reaching the node later by
+  // another airway can save the airway change factor on this edge. Divide by the factor to keep the
+  // estimate admissible.
+  for(int index : closedNodeIndexes)
+  {
+    if(index >= 0)
+      at(nodeEstimateArr, index) = std::max(at(nodeEstimateArr, index),
+                                            (destCosts - at(nodeCostArr, index)) / COST_FACTOR_AIRWAY_CHANGE);
+  }
+
+  // Store found path to reuse it for shortcuts ============
+  int current = destNode.index;
+  int pred = at(nodePredecessorArr, current);
+  while(pred != -1)
+  {
+    if(pred >= 0)
+    {
+      at(pathNextArr, pred) = current;
+      at(pathCostArr, pred) = at(nodeCostArr, current) - at(nodeCostArr, pred);
+      at(pathAirwayInArr, pred) = at(nodeAirwayArr, pred);
+      at(pathAirwayOutArr, pred) = at(nodeAirwayArr, current);
+      at(pathAirwayIdArr, pred) = at(nodeAirwayIdArr, current);
+      at(nodeEstimateArr, pred) = std::max(at(nodeEstimateArr, pred),
+                                           (destCosts - at(nodeCostArr, pred)) / COST_FACTOR_AIRWAY_CHANGE);
+    }
+    current = pred;
+    pred = at(nodePredecessorArr, current);
+  }
 }
 
 void RouteFinder::extractLegs(QVector<RouteLeg>& routeLegs, float& distanceMeter) const
@@ -270,6 +594,7 @@ void RouteFinder::extractLegs(QVector<RouteLeg>& routeLegs, float& distanceMeter
       leg.navId = pred.id;
       leg.type = pred.type;
       leg.airwayId = at(nodeAirwayIdArr, pred.index);
+      leg.nodeIndex = pred.index;
       leg.pos = pred.pos;
       routeLegs.prepend(leg);
     }
@@ -297,6 +622,29 @@ void RouteFinder::allocArrays()
   closedNodes = atools::allocArray<bool>(num);
 }
 
+void RouteFinder::allocIncrementalArrays()
+{
+  freeIncrementalArrays();
+  int num = network->getNodes().size() + 3;
+
+  nodeEstimateArr = atools::allocArray<float>(num);
+  pathNextArr = atools::allocArray<int>(num, -1);
+  pathCostArr = atools::allocArray<float>(num);
+  pathAirwayInArr = atools::allocArray<quint32>(num);
+  pathAirwayOutArr = atools::allocArray<quint32>(num);
+  pathAirwayIdArr = atools::allocArray<int>(num, -1);
+}
+
+void RouteFinder::freeIncrementalArrays()
+{
+  atools::freeArray(nodeEstimateArr);
+  atools::freeArray(pathNextArr);
+  atools::freeArray(pathCostArr);
+  atools::freeArray(pathAirwayInArr);
+  atools::freeArray(pathAirwayOutArr);
+  atools::freeArray(pathAirwayIdArr);
+}
+
 void RouteFinder::freeArrays()
 {
   atools::freeArray(nodeAirwayArr);
@@ -315,6 +663,7 @@ QDebug operator<<(QDebug out, const RouteLeg& obj)
   out.nospace().noquote() << "RouteLeg("
                           << "id " << obj.navId
                           << ", airway " << obj.airwayId
+                          << ", index " << obj.nodeIndex
                           << ", " << obj.pos
                           << ", type " << obj.type
                           << ")";
@@ -20,6 +20,10 @@
 
 #include "util/heap.h"
 #include "routing/routenetworktypes.h"
+#include "grib/windquery.h"
+
+#include <QHash>
+#include <QSet>
 
 namespace atools {
 namespace routing {
@@ -29,7 +33,8 @@ class RouteNetwork;
 struct RouteLeg
 {
   int navId, /* Network ID as used as node id in the network */
-      airwayId; /* Airway ID as used in the network or -1 if not applicable */
+      airwayId, /* Airway ID as used in the network or -1 if not applicable */
+      nodeIndex; /* Internal network node index. Only valid for the same network load. */
   atools::routing::NodeType type; /* Network type */
   atools::geo::Pos pos;
 
@@ -77,6 +82,70 @@ public:
     preferNdbToAirway = value;
   }
 
+  /* Calculate costs as travel time instead of distance using the winds at the flown altitude as given in
+   * calculateRoute. trueAirspeedKts is the cruise speed.
+   * Time mode is only used if flown altitude is not 0 and the query has wind data. Set query to null to disable.
+   * Average winds for network edges are cached and the cache is cleared if wind data, altitude or network change. */
+  void setWindQuery(const atools::grib::WindQuery *query, float trueAirspeedKts)
+  {
+    windQuery = query;
+    trueAirspeed = trueAirspeedKts;
+  }
+
+  /* Fill the edge wind cache for all airway edges of the network at the given altitude in feet.
+   * Optional. Can be used to move the wind calculation out of the first route calculation. */
+  void precalculateEdgeWinds(int flownAltitude);
+
+  /* Keep the search state between calls of calculateRoute and reuse it for re-routing to the same destination
+   * with unchanged parameters, e.g. in flight with a moving departure position.
+   * Nodes closed in earlier searches get improved cost estimates to the destination and paths found earlier
+   * are used as shortcuts to the destination. State is reset automatically if destination, altitude, mode,
+   * winds or network change. */
+  void setIncremental(bool value);
+
+  bool isIncremental() const
+  {
+    return incremental;
+  }
+
+  /* Drop all state collected by earlier searches in incremental mode */
+  void resetIncremental();
+
+  /* Exclude the edge between the two network nodes given by index from routing, e.g. for a closed airway segment.
+   * Stored paths using the edge are dropped. Learned estimates are kept since costs can only increase. */
+  void blockEdge(int fromIndex, int toIndex);
+
+  /* Allow all blocked edges again. Resets incremental state since costs might decrease. */
+  void clearBlockedEdges();
+
+  /* Multiply costs of the edge between the two nodes given by index with factor which has to be >= 1.
+   * Nodes can also be Node::DEPARTURE_INDEX or Node::DESTINATION_INDEX.
+   * Used to find alternative routes. Stored paths using the edge are dropped like for blockEdge(). */
+  void setEdgePenalty(int fromIndex, int toIndex, float factor);
+
+  float getEdgePenalty(int fromIndex, int toIndex) const
+  {
+    return edgePenalties.value(edgeKey(fromIndex, toIndex), 1.f);
+  }
+
+  /* Key for edge hashes as used in getEdgePenalties() */
+  static quint64 edgeKey(int fromIndex, int toIndex)
+  {
+    return (static_cast<quint64>(static_cast<quint32>(fromIndex)) << 32) | static_cast<quint32>(toIndex);
+  }
+
+  /* Remove all penalties. Resets incremental state since costs decrease. */
+  void clearEdgePenalties();
+
+  /* All penalties by edge key. Can be used to save and restore penalties with setEdgePenalties(). */
+  const QHash<quint64, float>& getEdgePenalties() const
+  {
+    return edgePenalties;
+  }
+
+  /* Replace all penalties. Resets incremental state since costs might decrease. */
+  void setEdgePenalties(const QHash<quint64, float>& penalties);
+
   /* Extract legs of shortest route and distance not including departure and destination. */
   void extractLegs(QVector<RouteLeg>& routeLegs, float& distanceMeter) const;
 
@@ -105,12 +174,40 @@ private:
   float calculateEdgeCost(const atools::routing::Node& node, const atools::routing::Node& successorNode,
                           const Edge& edge);
 
-  /* GC distance in meter as costs between nodes */
+  /* Edge length in meter or, if winds are used, equivalent still air distance in meter which is proportional
+   * to the travel time */
+  float calculateEdgeBaseCost(const atools::routing::Node& currentNode, const atools::routing::Node& successorNode,
+                              const Edge& edge);
+
+  /* Get average wind for the edge between the two nodes at the current altitude. Uses cache for network nodes. */
+  atools::grib::Wind edgeWind(const atools::routing::Node& currentNode, const atools::routing::Node& successorNode);
+
+  /* Clear edge wind cache if wind data, altitude or network changed */
+  void updateWindCache();
+
+  /* GC distance in meter as costs between nodes. Reduced by maximum tailwind if winds are used. */
   float costEstimate(const atools::routing::Node& currentNode, const atools::routing::Node& nextNode);
   bool combineRanges(quint16 min1, quint16 max1, quint16 min, quint16 max);
 
+  /* Check if the incremental state can be used for the current parameters and reset it otherwise */
+  void updateIncremental();
+
+  /* Use a stored path from node to destination as a shortcut if the incoming airway matches */
+  void relaxStoredPath(const atools::routing::Node& node);
+
+  /* Costs of the stored path from node index to destination or -1 if there is none or it is not valid anymore */
+  float storedPathCosts(int index, quint32 airwayHash) const;
+
+  /* Copy the stored path starting at index into the predecessor arrays */
+  void unrollStoredPath(int index);
+
+  /* Update estimates and store path after a successful search */
+  void learnFromSearch();
+
   void freeArrays();
   void allocArrays();
+  void freeIncrementalArrays();
+  void allocIncrementalArrays();
 
   /* Force algortihm to avoid direct route from start to destination */
   static Q_DECL_CONSTEXPR float COST_FACTOR_DIRECT = 2.f;
@@ -138,6 +235,9 @@ private:
   /* Avoid airway changes during routing */
   static Q_DECL_CONSTEXPR float COST_FACTOR_AIRWAY_CHANGE = 1.2f;
 
+  /* Ground speed is not allowed to drop below this fraction of true airspeed in strong headwinds */
+  static Q_DECL_CONSTEXPR float MIN_GROUND_SPEED_FACTOR = 0.1f;
+
   /* Altitude to use  for airway selection of 0 if not used */
   int altitude = 0;
 
@@ -180,6 +280,79 @@ private:
 
   bool preferVorToAirway = false, preferNdbToAirway = false;
 
+  /* Wind for time based costs */
+  const atools::grib::WindQuery *windQuery = nullptr;
+  float trueAirspeed = 0.f;
+
+  /* true if current calculation uses wind and time as costs */
+  bool useWind = false;
+
+  /* Multiplied with the GC distance for the estimate. Less than 1 if winds are used to keep the estimate admissible. */
+  float costEstimateFactor = 1.f;
+
+  /* Average wind at altitude for network edges. Key is from index in upper and to index in lower 32 bits. */
+  QHash<quint64, atools::grib::Wind> edgeWindCache;
+
+  /* Values the edge wind cache is valid for */
+  quint32 windCacheDataVersion = 0, windCacheNetworkCounter = 0;
+  int windCacheAltitude = 0;
+
+  /* Incremental search ========================================================= */
+
+  /* Parameters the incremental state is valid for */
+  struct IncrementalParameters
+  {
+    atools::geo::Pos destination;
+    int altitude = 0;
+    atools::routing::Modes mode = atools::routing::MODE_ALL;
+    quint32 networkLoadCounter = 0, windDataVersion = 0;
+    float trueAirspeed = 0.f;
+    bool useWind = false, preferVorToAirway = false, preferNdbToAirway = false;
+
+    bool operator==(const IncrementalParameters& other) const;
+
+    bool operator!=(const IncrementalParameters& other) const
+    {
+      return !operator==(other);
+    }
+
+  };
+
+  bool incremental = false;
+
+  /* true if the incremental arrays are allocated and valid for the current search */
+  bool incrementalValid = false;
+  IncrementalParameters incrementalParameters;
+
+  /* Nodes closed in the current search. Used to update estimates. */
+  QVector<int> closedNodeIndexes;
+
+  /* Node from which the destination was reached using a stored path or -1 */
+  int shortcutIndex = -1;
+
+  /* Learned lower bound of costs from node to destination. 0 if not known.
+   * Independent of the incoming airway since it is divided by COST_FACTOR_AIRWAY_CHANGE. */
+  float *nodeEstimateArr = nullptr;
+
+  /* Stored paths to destination from earlier searches. Next node index or -1 if no path is stored. */
+  int *pathNextArr = nullptr;
+
+  /* Costs including all factors to the next node */
+  float *pathCostArr = nullptr;
+
+  /* Airway hash of the edge leading into this node and of the edge leading to the next node */
+  quint32 *pathAirwayInArr = nullptr;
+  quint32 *pathAirwayOutArr = nullptr;
+
+  /* Airway id of the edge to the next node */
+  int *pathAirwayIdArr = nullptr;
+
+  /* Edges excluded from routing. Key is from index in upper and to index in lower 32 bits. */
+  QSet<quint64> blockedEdges;
+
+  /* Cost factors for edges. Same key as above. */
+  QHash<quint64, float> edgePenalties;
+
   /* Direct euclidian distances in 3D space for callback */
   int distMeterToDest = 0, currentDistMeterToDest = 0;
   RouteFinderCallbackType callback;
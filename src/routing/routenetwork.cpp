@@ -401,6 +401,7 @@ void RouteNetwork::initInternal()
       e.lengthMeter =
         atools::roundToInt(nodeIndex.atPoint3D(n.index).gcDistanceMeter(nodeIndex.atPoint3D(e.toIndex)));
   }
+  loadCounter++;
 
   qDebug() << Q_FUNC_INFO << timer.restart() << "ms";
 }
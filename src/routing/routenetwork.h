@@ -112,6 +112,12 @@ public:
     return nodeIndex;
   }
 
+  /* Incremented each time the network is loaded. Node indexes are only valid for the same load counter. */
+  quint32 getLoadCounter() const
+  {
+    return loadCounter;
+  }
+
   /* true if airways and other navaids are used as data source. Otherwise radio navaid only. */
   bool isAirwayRouting() const
   {
@@ -222,6 +228,8 @@ private:
   QHash<int, int> nodeIdIndexMap;
 
   atools::routing::DataSource source = atools::routing::SOURCE_NONE;
+
+  quint32 loadCounter = 0;
 };
 
 } // namespace routing
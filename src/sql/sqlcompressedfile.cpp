@@ -0,0 +1,208 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "sql/sqlcompressedfile.h"
+
+#include "exception.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+namespace atools {
+namespace sql {
+
+/* Identifies a compressed database file */
+static const char MAGIC[8] = {'A', 'T', 'S', 'Q', 'L', 'Z', '0', '1'};
+
+/* Magic plus block size, number of blocks and uncompressed size */
+static const int HEADER_SIZE = 8 + 4 + 4 + 8;
+
+/* All SQLite database files start with this string */
+static const QByteArray SQLITE_MAGIC("SQLite format 3\0", 16);
+
+/* Read header and block index. Returns false if the file is not a compressed database. */
+static bool readHeader(QFile& file, QByteArray& header, QByteArray& index, quint32& blockSize, quint32& numBlocks,
+                       quint64& uncompressedSize)
+{
+  header = file.read(HEADER_SIZE);
+  if(header.size() != HEADER_SIZE || !header.startsWith(QByteArray(MAGIC, sizeof(MAGIC))))
+    return false;
+
+  const uchar *data = reinterpret_cast<const uchar *>(header.constData()) + sizeof(MAGIC);
+  blockSize = qFromLittleEndian<quint32>(data);
+  numBlocks = qFromLittleEndian<quint32>(data + 4);
+  uncompressedSize = qFromLittleEndian<quint64>(data + 8);
+
+  qint64 indexSize = static_cast<qint64>((static_cast<quint64>(numBlocks) + 1) * sizeof(quint64));
+  if(blockSize == 0 || static_cast<quint64>(numBlocks) * blockSize < uncompressedSize ||
+     indexSize > file.size() - HEADER_SIZE)
+    return false;
+
+  index = file.read(indexSize);
+  return index.size() == indexSize;
+}
+
+void SqlCompressedFile::compress(const QString& databaseFile, const QString& compressedFile, int blockSize)
+{
+  if(blockSize <= 0)
+    throw atools::Exception(QObject::tr("Invalid block size %1 for compressed file \"%2\".").
+                            arg(blockSize).arg(compressedFile));
+
+  QElapsedTimer timer;
+  timer.start();
+
+  QFile in(databaseFile);
+  if(!in.open(QIODevice::ReadOnly))
+    throw atools::Exception(QObject::tr("Cannot open file \"%1\". Reason: %2.").
+                            arg(databaseFile).arg(in.errorString()));
+
+  if(in.peek(SQLITE_MAGIC.size()) != SQLITE_MAGIC)
+    throw atools::Exception(QObject::tr("File \"%1\" is not a SQLite database.").arg(databaseFile));
+
+  QSaveFile out(compressedFile);
+  if(!out.open(QIODevice::WriteOnly))
+    throw atools::Exception(QObject::tr("Cannot open file \"%1\". Reason: %2.").
+                            arg(compressedFile).arg(out.errorString()));
+
+  quint64 size = static_cast<quint64>(in.size());
+  quint32 numBlocks = static_cast<quint32>((size + static_cast<quint64>(blockSize) - 1) / blockSize);
+
+  // Header ========================
+  QByteArray header(HEADER_SIZE, '\0');
+  uchar *data = reinterpret_cast<uchar *>(header.data());
+  memcpy(data, MAGIC, sizeof(MAGIC));
+  qToLittleEndian<quint32>(static_cast<quint32>(blockSize), data + sizeof(MAGIC));
+  qToLittleEndian<quint32>(numBlocks, data + sizeof(MAGIC) + 4);
+  qToLittleEndian<quint64>(size, data + sizeof(MAGIC) + 8);
+  out.write(header);
+
+  // Compress blocks and collect offsets ========================
+  QByteArray index(static_cast<int>((numBlocks + 1) * sizeof(quint64)), '\0');
+  uchar *indexData = reinterpret_cast<uchar *>(index.data());
+  quint64 offset = static_cast<quint64>(HEADER_SIZE + index.size());
+
+  // Placeholder for index which is written after all blocks
+  out.write(index);
+
+  for(quint32 i = 0; i < numBlocks; i++)
+  {
+    QByteArray compressed = qCompress(in.read(blockSize), 9);
+    qToLittleEndian<quint64>(offset, indexData + i * sizeof(quint64));
+    out.write(compressed);
+    offset += static_cast<quint64>(compressed.size());
+  }
+  qToLittleEndian<quint64>(offset, indexData + numBlocks * sizeof(quint64));
+
+  out.seek(HEADER_SIZE);
+  out.write(index);
+
+  if(in.error() != QFileDevice::NoError || !out.commit())
+    throw atools::Exception(QObject::tr("Cannot write file \"%1\". Reason: %2.").
+                            arg(compressedFile).arg(out.errorString()));
+
+  qDebug() << Q_FUNC_INFO << databaseFile << size << "bytes to" << compressedFile << offset << "bytes"
+           << timer.elapsed() << "ms";
+}
+
+void SqlCompressedFile::uncompress(const QString& compressedFile, const QString& databaseFile)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  QFile in(compressedFile);
+  if(!in.open(QIODevice::ReadOnly))
+    throw atools::Exception(QObject::tr("Cannot open file \"%1\". Reason: %2.").
+                            arg(compressedFile).arg(in.errorString()));
+
+  QByteArray header, index;
+  quint32 blockSize, numBlocks;
+  quint64 uncompressedSize;
+  if(!readHeader(in, header, index, blockSize, numBlocks, uncompressedSize))
+    throw atools::Exception(QObject::tr("File \"%1\" is not a compressed database.").arg(compressedFile));
+
+  QSaveFile out(databaseFile);
+  if(!out.open(QIODevice::WriteOnly))
+    throw atools::Exception(QObject::tr("Cannot open file \"%1\". Reason: %2.").
+                            arg(databaseFile).arg(out.errorString()));
+
+  const uchar *indexData = reinterpret_cast<const uchar *>(index.constData());
+  for(quint32 i = 0; i < numBlocks; i++)
+  {
+    quint64 offset = qFromLittleEndian<quint64>(indexData + i * sizeof(quint64));
+    quint64 nextOffset = qFromLittleEndian<quint64>(indexData + (i + 1) * sizeof(quint64));
+
+    QByteArray data;
+    if(nextOffset > offset && in.seek(static_cast<qint64>(offset)))
+      data = qUncompress(in.read(static_cast<qint64>(nextOffset - offset)));
+
+    quint64 expectedSize = std::min(static_cast<quint64>(blockSize),
+                                    uncompressedSize - static_cast<quint64>(i) * blockSize);
+    if(static_cast<quint64>(data.size()) != expectedSize)
+      throw atools::Exception(QObject::tr("Invalid block %1 in compressed database \"%2\".").
+                              arg(i).arg(compressedFile));
+    out.write(data);
+  }
+
+  if(!out.commit())
+    throw atools::Exception(QObject::tr("Cannot write file \"%1\". Reason: %2.").
+                            arg(databaseFile).arg(out.errorString()));
+
+  qDebug() << Q_FUNC_INFO << compressedFile << "to" << databaseFile << uncompressedSize << "bytes"
+           << timer.elapsed() << "ms";
+}
+
+QString SqlCompressedFile::fileStamp(const QString& compressedFile)
+{
+  QFile in(compressedFile);
+  if(!in.open(QIODevice::ReadOnly))
+    return QString();
+
+  QByteArray header, index;
+  quint32 blockSize, numBlocks;
+  quint64 uncompressedSize;
+  if(!readHeader(in, header, index, blockSize, numBlocks, uncompressedSize))
+    return QString();
+
+  // Block offsets change with any change of the content
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  hash.addData(header);
+  hash.addData(index);
+
+  return QString("%1 %2 %3").arg(in.size()).arg(QFileInfo(in).lastModified().toMSecsSinceEpoch()).
+         arg(QString(hash.result().toHex()));
+}
+
+bool SqlCompressedFile::isCompressed(const QString& filename)
+{
+  QFile testFile(filename);
+  if(testFile.open(QIODevice::ReadOnly))
+    return testFile.read(sizeof(MAGIC)) == QByteArray(MAGIC, sizeof(MAGIC));
+
+  return false;
+}
+
+} // namespace sql
+} // namespace atools
@@ -0,0 +1,61 @@
+/*****************************************************************************
+* Copyright 2015-2019 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_SQL_SQLCOMPRESSEDFILE_H
+#define ATOOLS_SQL_SQLCOMPRESSEDFILE_H
+
+#include <QString>
+
+namespace atools {
+namespace sql {
+
+/*
+ * Archive format for finished read-only SQLite databases which are distributed.
+ *
+ * The file is split into blocks of equal size which are compressed separately using zlib. This keeps
+ * memory usage low when compressing and uncompressing large files. The database has to be uncompressed
+ * before use. See SqlDatabase::setCompressedDatabaseName().
+ *
+ * Format (all numbers little endian):
+ * 8 bytes magic, quint32 block size, quint32 number of blocks, quint64 uncompressed size,
+ * (number of blocks + 1) quint64 file offsets of blocks, compressed blocks.
+ *
+ * Methods throw atools::Exception on errors.
+ */
+class SqlCompressedFile
+{
+public:
+  SqlCompressedFile() = delete;
+
+  /* Compress a closed SQLite database file. Throws an exception if blockSize is not positive. */
+  static void compress(const QString& databaseFile, const QString& compressedFile, int blockSize = 65536);
+
+  /* Uncompress the whole file */
+  static void uncompress(const QString& compressedFile, const QString& databaseFile);
+
+  /* true if file exists and has the magic number of a compressed file */
+  static bool isCompressed(const QString& filename);
+
+  /* Identifies the content of a compressed file by size, modification time and a checksum of header
+   * and block index. Used to detect if an uncompressed copy is outdated. Empty if file cannot be read. */
+  static QString fileStamp(const QString& compressedFile);
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLCOMPRESSEDFILE_H
@@ -19,10 +19,12 @@
 #include "sql/sqlexception.h"
 #include "sql/sqlquery.h"
 #include "sql/sqlrecord.h"
+#include "sql/sqlcompressedfile.h"
 
 #include <QSettings>
 #include <QDebug>
 #include <QFileInfo>
+#include <QDir>
 #include <QSqlIndex>
 #include <QSqlDriver>
 
@@ -301,6 +303,44 @@ void SqlDatabase::setDatabaseName(const QString& name)
   db.setDatabaseName(name);
 }
 
+void SqlDatabase::setCompressedDatabaseName(const QString& compressedFile, const QString& cacheDir)
+{
+  checkError(!isOpen(), "SqlDatabase::setCompressedDatabaseName() on opened database");
+
+  QFileInfo compressed(compressedFile);
+  QFileInfo uncompressed(QDir(cacheDir).absoluteFilePath(compressed.completeBaseName()));
+
+  // Stamp of the compressed file is saved next to the uncompressed copy - modification time alone
+  // does not detect replacements with older files
+  QString stamp = SqlCompressedFile::fileStamp(compressedFile);
+  QFile stampFile(uncompressed.filePath() + ".stamp");
+  QString cachedStamp;
+  if(stampFile.open(QIODevice::ReadOnly))
+  {
+    cachedStamp = QString::fromUtf8(stampFile.readAll());
+    stampFile.close();
+  }
+
+  if(!uncompressed.exists() || stamp.isEmpty() || stamp != cachedStamp)
+  {
+    qInfo() << Q_FUNC_INFO << "Uncompressing" << compressedFile << "to" << uncompressed.filePath();
+    QDir().mkpath(cacheDir);
+    SqlCompressedFile::uncompress(compressedFile, uncompressed.filePath());
+
+    if(stampFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+      stampFile.write(stamp.toUtf8());
+      stampFile.close();
+    }
+    else
+      qWarning() << Q_FUNC_INFO << "Cannot write" << stampFile.fileName() << stampFile.errorString();
+  }
+
+  db.setDatabaseName(uncompressed.filePath());
+  db.setConnectOptions("QSQLITE_OPEN_READONLY");
+  readonly = true;
+}
+
 void SqlDatabase::setUserName(const QString& name)
 {
   checkError(!isOpen(), "SqlDatabase::setUserName() on opened database");
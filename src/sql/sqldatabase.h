@@ -87,6 +87,13 @@ public:
   void transaction();
 
   void setDatabaseName(const QString& name);
+
+  /* Sqlite only. Use a database compressed by SqlCompressedFile::compress().
+   * The file is uncompressed into cacheDir once and again only if the compressed file changed. A file with
+   * the suffix ".stamp" is stored next to the uncompressed file to detect changes.
+   * The uncompressed file has the name of the compressed file without the last suffix.
+   * The database is set to read only. Call open() afterwards. */
+  void setCompressedDatabaseName(const QString& compressedFile, const QString& cacheDir);
   void setUserName(const QString& name);
   void setPassword(const QString& password);
   void setHostName(const QString& host);
@@ -76,6 +76,12 @@ public:
     return heap.empty();
   }
 
+  /* Remove all elements but keep the reserved space */
+  void clear()
+  {
+    heap.clear();
+  }
+
   int size() const
   {
     return heap.size();